@@ -0,0 +1,351 @@
+/*
+ * gentree.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ * Generates a reproducible tree of photo files for benchmarking scans:
+ * minimal baseline JPEGs with an EXIF block (capture time and pixel
+ * dimensions), a log-uniform size distribution and a share of exact
+ * duplicates. With --evict instead drops a tree from the page cache.
+ */
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct options_t
+{
+	uint64_t seed;
+	unsigned depth;
+	unsigned fanout;
+	unsigned files;
+	uint64_t min_size;
+	uint64_t max_size;
+	double dups;
+
+	options_t()
+	 : seed(1), depth(2), fanout(8), files(10000), min_size(256 << 10), max_size(8 << 20), dups(0.05)
+	{
+	}
+};
+
+// What a file contains follows entirely from this, so duplicates reuse it.
+struct content_t
+{
+	uint64_t seed;
+	uint64_t size;
+	unsigned width;
+	unsigned height;
+	time_t taken;
+};
+
+class writer_t
+{
+private:
+	std::vector<unsigned char> data;
+public:
+	void u8(unsigned v)
+	{
+		data.push_back(v & 0xff);
+	}
+	void be16(unsigned v)
+	{
+		u8(v >> 8);
+		u8(v);
+	}
+	void le16(unsigned v)
+	{
+		u8(v);
+		u8(v >> 8);
+	}
+	void le32(uint32_t v)
+	{
+		le16(v & 0xffff);
+		le16(v >> 16);
+	}
+	void bytes(const void* p, size_t n)
+	{
+		auto c = static_cast<const unsigned char*>(p);
+		data.insert(data.end(), c, c + n);
+	}
+	size_t size() const
+	{
+		return data.size();
+	}
+	void patch_be16(size_t at, unsigned v)
+	{
+		data[at] = (v >> 8) & 0xff;
+		data[at + 1] = v & 0xff;
+	}
+	const std::vector<unsigned char>& get() const
+	{
+		return data;
+	}
+};
+
+// Little endian TIFF with IFD0 pointing at an Exif IFD.
+std::vector<unsigned char> exif_block(const content_t& c)
+{
+	char datetime[20];
+	struct tm tm;
+	gmtime_r(&c.taken, &tm);
+	strftime(datetime, sizeof(datetime), "%Y:%m:%d %H:%M:%S", &tm);
+
+	writer_t w;
+	w.bytes("Exif\0\0", 6);
+
+	const size_t tiff = w.size();
+	w.bytes("II", 2);
+	w.le16(42);
+	w.le32(8);
+
+	// IFD0: ImageWidth, ImageLength, DateTime, ExifIFD pointer.
+	const uint32_t ifd0 = 8;
+	const uint32_t ifd0_size = 2 + 4 * 12 + 4;
+	const uint32_t exif_ifd = ifd0 + ifd0_size;
+	const uint32_t exif_ifd_size = 2 + 3 * 12 + 4;
+	const uint32_t strings = exif_ifd + exif_ifd_size;
+
+	w.le16(4);
+	w.le16(0x0100); w.le16(4); w.le32(1); w.le32(c.width);
+	w.le16(0x0101); w.le16(4); w.le32(1); w.le32(c.height);
+	w.le16(0x0132); w.le16(2); w.le32(20); w.le32(strings);
+	w.le16(0x8769); w.le16(4); w.le32(1); w.le32(exif_ifd);
+	w.le32(0);
+
+	// Exif IFD: DateTimeOriginal, PixelXDimension, PixelYDimension.
+	w.le16(3);
+	w.le16(0x9003); w.le16(2); w.le32(20); w.le32(strings + 20);
+	w.le16(0xa002); w.le16(4); w.le32(1); w.le32(c.width);
+	w.le16(0xa003); w.le16(4); w.le32(1); w.le32(c.height);
+	w.le32(0);
+
+	assert(w.size() - tiff == strings);
+	w.bytes(datetime, 20);
+	w.bytes(datetime, 20);
+	return w.get();
+}
+
+std::vector<unsigned char> jpeg(const content_t& c)
+{
+	writer_t w;
+	w.be16(0xffd8);
+
+	auto exif = exif_block(c);
+	w.be16(0xffe1);
+	w.be16(exif.size() + 2);
+	w.bytes(exif.data(), exif.size());
+
+	// Baseline frame header, 3 components.
+	w.be16(0xffc0);
+	w.be16(17);
+	w.u8(8);
+	w.be16(c.height);
+	w.be16(c.width);
+	w.u8(3);
+	for(unsigned i = 1; i <= 3; ++i)
+	{
+		w.u8(i);
+		w.u8(0x11);
+		w.u8(0);
+	}
+
+	w.be16(0xffda);
+	w.be16(12);
+	w.u8(3);
+	for(unsigned i = 1; i <= 3; ++i)
+	{
+		w.u8(i);
+		w.u8(0);
+	}
+	w.u8(0);
+	w.u8(63);
+	w.u8(0);
+	return w.get();
+}
+
+bool write_file(const std::string& name, const content_t& c)
+{
+	auto header = jpeg(c);
+
+	FILE* f = fopen(name.c_str(), "wb");
+	if(!f)
+	{
+		std::cerr << name << ": " << strerror(errno) << "\n";
+		return false;
+	}
+
+	fwrite(header.data(), 1, header.size(), f);
+
+	// Scan data, never 0xff so nothing reads as a marker.
+	std::mt19937_64 rng(c.seed);
+	std::vector<unsigned char> buf(64 << 10);
+	uint64_t remaining = c.size > header.size() + 2 ? c.size - header.size() - 2 : 0;
+	while(remaining)
+	{
+		size_t n = std::min<uint64_t>(remaining, buf.size());
+		for(size_t i = 0; i < n; i += 8)
+		{
+			uint64_t r = rng();
+			for(size_t j = 0; j < 8 && i + j < n; ++j, r >>= 8)
+				buf[i + j] = (r & 0xff) % 0xff;
+		}
+		fwrite(buf.data(), 1, n, f);
+		remaining -= n;
+	}
+
+	static const unsigned char eoi[] = {0xff, 0xd9};
+	fwrite(eoi, 1, 2, f);
+	return fclose(f) == 0;
+}
+
+void leaves(const std::string& path, unsigned depth, unsigned fanout, std::vector<std::string>& dirs)
+{
+	mkdir(path.c_str(), 0755);
+	if(!depth)
+	{
+		dirs.push_back(path);
+		return;
+	}
+
+	for(unsigned i = 0; i < fanout; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "/%03u", i);
+		leaves(path + name, depth - 1, fanout, dirs);
+	}
+}
+
+void evict(const std::string& path)
+{
+	auto delete_dir = [](DIR* d){ closedir(d); };
+	std::unique_ptr<DIR, decltype(delete_dir)> dir(opendir(path.c_str()), delete_dir);
+	if(!dir)
+		return;
+
+	while(dirent* entry = readdir(dir.get()))
+	{
+		std::string name = entry->d_name;
+		if(entry->d_type == DT_DIR)
+		{
+			if(name != "." && name != "..")
+				evict(path + '/' + name);
+		}
+		else if(entry->d_type == DT_REG)
+		{
+			int fd = open((path + '/' + name).c_str(), O_RDONLY);
+			if(fd == -1)
+				continue;
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+	}
+}
+
+bool option(const std::string& arg, const std::string& name, std::string& value)
+{
+	if(arg.compare(0, name.size() + 1, name + '=') != 0)
+		return false;
+	value = arg.substr(name.size() + 1);
+	return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> args(argv, argv+argc);
+
+	options_t options;
+	bool do_evict(false);
+	std::string dest;
+	for(size_t i = 1; i < args.size(); ++i)
+	{
+		std::string value;
+		if(args[i] == "--evict")
+			do_evict = true;
+		else if(option(args[i], "--seed", value))
+			options.seed = std::stoull(value);
+		else if(option(args[i], "--depth", value))
+			options.depth = std::stoul(value);
+		else if(option(args[i], "--fanout", value))
+			options.fanout = std::stoul(value);
+		else if(option(args[i], "--files", value))
+			options.files = std::stoul(value);
+		else if(option(args[i], "--min-size", value))
+			options.min_size = std::stoull(value) << 10;
+		else if(option(args[i], "--max-size", value))
+			options.max_size = std::stoull(value) << 10;
+		else if(option(args[i], "--dups", value))
+			options.dups = std::stod(value);
+		else
+			dest = args[i];
+	}
+
+	if(dest.empty() || options.min_size > options.max_size || !options.fanout)
+	{
+		std::cerr << args[0] << " [--seed=N] [--depth=N] [--fanout=N] [--files=N] [--min-size=KB] [--max-size=KB] [--dups=ratio] dest\n";
+		std::cerr << args[0] << " --evict dest\n";
+		return 1;
+	}
+
+	if(do_evict)
+	{
+		evict(dest);
+		return 0;
+	}
+
+	std::vector<std::string> dirs;
+	leaves(dest, options.depth, options.fanout, dirs);
+
+	std::mt19937_64 rng(options.seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double log_min = std::log(std::max<uint64_t>(options.min_size, 1));
+	const double log_max = std::log(std::max<uint64_t>(options.max_size, 1));
+	static const unsigned widths[] = {4000, 4032, 5472, 6000, 1920};
+
+	std::vector<content_t> made;
+	uint64_t bytes(0);
+	for(unsigned n = 0; n < options.files; ++n)
+	{
+		content_t c;
+		if(!made.empty() && unit(rng) < options.dups)
+		{
+			c = made[rng() % made.size()];
+		}
+		else
+		{
+			c.seed = rng();
+			c.size = std::exp(log_min + (log_max - log_min) * unit(rng));
+			c.width = widths[rng() % (sizeof(widths) / sizeof(*widths))];
+			c.height = c.width * 3 / 4;
+			// Sometime in 2010-2020.
+			c.taken = 1262304000 + rng() % (10 * 365 * 86400ULL);
+			made.push_back(c);
+		}
+
+		char name[32];
+		snprintf(name, sizeof(name), "/IMG_%06u.JPG", n);
+		if(!write_file(dirs[n % dirs.size()] + name, c))
+			return 1;
+		bytes += c.size;
+	}
+
+	std::cout << options.files << " files (" << made.size() << " distinct), " << (bytes >> 20) << " MB in " << dirs.size() << " directories\n";
+	return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * micro_bench.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ * Benchmarks for the per-file primitives. Run with
+ * --benchmark_format=json (or --benchmark_out=file.json) to compare runs.
+ */
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "db.h"
+#include "hash.h"
+#include "photo.h"
+#include "sha1.h"
+#include "timestamp.h"
+
+namespace
+{
+
+std::vector<unsigned char> random_bytes(size_t n)
+{
+	std::mt19937_64 rng(1);
+	std::vector<unsigned char> data(n);
+	for(auto& c : data)
+		c = rng();
+	return data;
+}
+
+void sha1_calc(benchmark::State& state)
+{
+	auto data = random_bytes(state.range(0));
+	unsigned char hash[20];
+	for(auto _ : state)
+	{
+		sha1::calc(data.data(), data.size(), hash);
+		benchmark::DoNotOptimize(hash);
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+// Empty, a thumbnail, a typical jpeg and a raw file.
+BENCHMARK(sha1_calc)->Arg(0)->Arg(16 << 10)->Arg(4 << 20)->Arg(24 << 20);
+
+// The same sizes through each hasher_t this build has, to compare with sha1_calc.
+void hasher(benchmark::State& state, hasher_t::algorithm_t algorithm)
+{
+	if(!hasher_t::create(algorithm))
+	{
+		state.SkipWithError("not built in");
+		return;
+	}
+
+	auto data = random_bytes(state.range(0));
+	for(auto _ : state)
+	{
+		auto h = hasher_t::create(algorithm);
+		h->update(data.data(), data.size());
+		benchmark::DoNotOptimize(h->final());
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK_CAPTURE(hasher, sha1, hasher_t::sha1)->Arg(16 << 10)->Arg(4 << 20)->Arg(24 << 20);
+BENCHMARK_CAPTURE(hasher, xxh3_128, hasher_t::xxh3_128)->Arg(16 << 10)->Arg(4 << 20)->Arg(24 << 20);
+BENCHMARK_CAPTURE(hasher, blake3, hasher_t::blake3)->Arg(16 << 10)->Arg(4 << 20)->Arg(24 << 20);
+
+void sha1_hex(benchmark::State& state)
+{
+	unsigned char hash[20];
+	sha1::calc("photo", 5, hash);
+	char hex[41];
+	for(auto _ : state)
+	{
+		sha1::toHexString(hash, hex);
+		benchmark::DoNotOptimize(hex);
+	}
+}
+BENCHMARK(sha1_hex);
+
+void timestamp_str(benchmark::State& state)
+{
+	timestamp_t ts(time_t(1381000000));
+	for(auto _ : state)
+		benchmark::DoNotOptimize(ts.str());
+}
+BENCHMARK(timestamp_str);
+
+void timestamp_parse(benchmark::State& state)
+{
+	const std::string s = timestamp_t(time_t(1381000000)).str();
+	for(auto _ : state)
+		benchmark::DoNotOptimize(timestamp_t(s));
+}
+BENCHMARK(timestamp_parse);
+
+void timestamp_from_time(benchmark::State& state)
+{
+	time_t t(1381000000);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(timestamp_t(t++));
+}
+BENCHMARK(timestamp_from_time);
+
+void dim_parse(benchmark::State& state)
+{
+	const std::string s = dim(6000, 4000).str();
+	for(auto _ : state)
+		benchmark::DoNotOptimize(dim(s));
+}
+BENCHMARK(dim_parse);
+
+void dim_str(benchmark::State& state)
+{
+	dim d(6000, 4000);
+	for(auto _ : state)
+		benchmark::DoNotOptimize(d.str());
+}
+BENCHMARK(dim_str);
+
+// Binds a photos row the way ingest_t::store does.
+void statement_bind(benchmark::State& state)
+{
+	db_t db(":memory:");
+	db.execute("CREATE TABLE photos (file_name TEXT, path TEXT, size INTEGER, mtime TEXT, timestamp TEXT, checksum TEXT, pixel_size TEXT, exif_size TEXT, rebuilt TEXT)");
+	db_t::statement_t<std::string, std::string, uint64_t, std::string, std::string, std::string, std::string, std::string, std::string> insert{db, "INSERT INTO photos VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"};
+
+	const std::string mtime = timestamp_t(time_t(1381000000)).str();
+	const std::string checksum(40, 'a');
+	const std::string pixel_size = dim(6000, 4000).str();
+	uint64_t n(0);
+
+	db.execute("BEGIN");
+	for(auto _ : state)
+		insert.execute("IMG_0001.JPG", "/photos/2013/10/05", ++n, mtime, mtime, checksum, pixel_size, pixel_size, mtime);
+	db.execute("COMMIT");
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(statement_bind);
+
+// Unpacks state.range(0) rows the way dir_cache_t and the lookups do.
+void statement_unpack(benchmark::State& state)
+{
+	db_t db(":memory:");
+	db.execute("CREATE TABLE photos (file_name TEXT, path TEXT, size INTEGER, mtime TEXT, checksum TEXT)");
+	{
+		db_t::statement_t<std::string, int64_t> insert{db, "INSERT INTO photos VALUES (?, '/photos/2013/10/05', ?, '2013-10-05 19:06:40', 'da39a3ee5e6b4b0d3255bfef95601890afd80709')"};
+		db.execute("BEGIN");
+		for(int64_t i = 0; i < state.range(0); ++i)
+			insert.execute("IMG_" + std::to_string(i) + ".JPG", i);
+		db.execute("COMMIT");
+	}
+
+	db_t::statement_t<> select{db, "SELECT file_name, path, size, mtime, checksum FROM photos"};
+	auto x = [](std::tuple<std::string, std::string, int64_t, std::string, std::string>& row)
+	{
+		benchmark::DoNotOptimize(row);
+	};
+	for(auto _ : state)
+		select.query<decltype(x), std::string, std::string, int64_t, std::string, std::string>(x);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(statement_unpack)->Arg(1000);
+
+}
+
+BENCHMARK_MAIN();
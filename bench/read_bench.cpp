@@ -0,0 +1,161 @@
+/*
+ * read_bench.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ * Hashes files with each read mode (and mmap_t hints) and reports
+ * throughput, page faults and how much of the files is left in the page
+ * cache afterwards.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mmap.h"
+#include "reader.h"
+#include "sha1.h"
+
+namespace
+{
+
+struct file_t
+{
+	std::string name;
+	uint64_t size;
+};
+
+void evict(const file_t& file)
+{
+	int fd = open(file.name.c_str(), O_RDONLY);
+	if(fd == -1)
+		return;
+	posix_fadvise(fd, 0, file.size, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+// Pages of the file currently in the page cache.
+uint64_t resident(const file_t& file)
+{
+	if(!file.size)
+		return 0;
+
+	mmap_t addr(file.name.c_str());
+	static const long page = sysconf(_SC_PAGESIZE);
+	std::vector<unsigned char> vec((addr.length() + page - 1) / page);
+	if(!addr.length() || mincore(addr, addr.length(), vec.data()) != 0)
+		return 0;
+	return std::count_if(begin(vec), end(vec), [](unsigned char c){ return c & 1; });
+}
+
+void hash(const file_t& file, const read_options& options)
+{
+	sha1::context ctx;
+	sha1::init(ctx);
+	read_file(file.name, options, [&ctx](const void* data, std::size_t length)
+	{
+		sha1::update(ctx, data, length);
+	});
+
+	unsigned char digest[20];
+	sha1::final(ctx, digest);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> args(argv, argv+argc);
+
+	bool warm(false);
+	std::vector<file_t> files;
+	for(size_t i = 1; i < args.size(); ++i)
+	{
+		if(args[i] == "--warm")
+		{
+			warm = true;
+			continue;
+		}
+
+		struct stat sb;
+		if(stat(args[i].c_str(), &sb) != 0 || !S_ISREG(sb.st_mode))
+		{
+			std::cerr << args[i] << ": Unable to stat()\n";
+			return 1;
+		}
+		files.push_back({args[i], static_cast<uint64_t>(sb.st_size)});
+	}
+
+	if(files.empty())
+	{
+		std::cerr << args[0] << " [--warm] file...\n";
+		return 1;
+	}
+
+	// map:<hints>, stream or direct.
+	const char* modes[] = {"map:none", "map:sequential", "map:willneed", "map:sequential,willneed", "map:populate", "map:hugepage", "map:sequential,dontneed", "map:populate,dontneed", "stream", "direct"};
+
+	static const long page = sysconf(_SC_PAGESIZE);
+	uint64_t bytes(0);
+	uint64_t pages(0);
+	for(auto& file : files)
+	{
+		bytes += file.size;
+		pages += (file.size + page - 1) / page;
+	}
+
+	std::cout << std::left << std::setw(28) << "mode" << std::right
+			  << std::setw(10) << "MB/s"
+			  << std::setw(12) << "minflt"
+			  << std::setw(12) << "majflt"
+			  << std::setw(10) << "cached%" << "\n";
+
+	for(auto mode : modes)
+	{
+		std::string name = mode;
+		read_options options;
+		if(name.compare(0, 4, "map:") == 0)
+			options.map_hints = parse_mmap_hints(name.c_str() + 4);
+		else
+			parse_read_mode(name, options.mode);
+
+		// Warm runs start from a fully cached file, cold ones from none of it.
+		for(auto& file : files)
+			if(warm)
+				hash(file, read_options());
+			else
+				evict(file);
+
+		struct rusage before;
+		getrusage(RUSAGE_SELF, &before);
+		auto start = std::chrono::steady_clock::now();
+
+		for(auto& file : files)
+			hash(file, options);
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		struct rusage after;
+		getrusage(RUSAGE_SELF, &after);
+
+		uint64_t cached(0);
+		for(auto& file : files)
+			cached += resident(file);
+
+		std::cout << std::left << std::setw(28) << mode << std::right << std::fixed << std::setprecision(1)
+				  << std::setw(10) << bytes / 1048576.0 / std::max(seconds, 1e-9)
+				  << std::setw(12) << after.ru_minflt - before.ru_minflt
+				  << std::setw(12) << after.ru_majflt - before.ru_majflt
+				  << std::setw(10) << (pages ? 100.0 * cached / pages : 0.0) << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# scan_bench.sh
+#
+#  Created on: 19/10/2026
+#
+# End to end scan benchmark: generates a tree with gentree and times
+# photodb importing it cold and warm, then rescanning it. Per-phase metrics
+# for each run are left as JSON in the work directory.
+#
+# scan_bench.sh photodb gentree workdir [gentree options...]
+
+set -e
+
+if [ $# -lt 3 ]; then
+	echo "$0 photodb gentree workdir [gentree options...]" >&2
+	exit 1
+fi
+
+photodb=$1
+gentree=$2
+work=$3
+shift 3
+
+tree=$work/tree
+rm -rf "$tree"
+mkdir -p "$work"
+"$gentree" "$@" "$tree"
+
+files=$(find "$tree" -type f -name '*.JPG' | wc -l)
+mb=$(du -sm "$tree" | cut -f1)
+
+summary=$work/summary.txt
+printf '%-12s %10s %10s %10s\n' run seconds files/s MB/s > "$summary"
+
+# run name cold [photodb options...]
+run()
+{
+	name=$1
+	cold=$2
+	shift 2
+	if [ "$cold" = cold ]; then
+		sync
+		"$gentree" --evict "$tree"
+	fi
+	start=$(date +%s%N)
+	"$photodb" --metrics="$work/$name.json" "$@" "$tree" > "$work/$name.log" 2>&1
+	end=$(date +%s%N)
+	awk -v n="$name" -v ns=$((end - start)) -v f="$files" -v mb="$mb" 'BEGIN {
+		s = ns / 1e9; if(s <= 0) s = 1e-9
+		printf "%-12s %10.3f %10.0f %10.1f\n", n, s, f / s, mb / s
+	}' >> "$summary"
+}
+
+rm -f "$tree"/photo.db*
+run import_cold cold
+rm -f "$tree"/photo.db*
+run import_warm warm
+run rescan warm
+run rescan_full warm --full
+run rescan_cold cold --full
+
+echo "$files files, $mb MB"
+cat "$summary"
@@ -0,0 +1,196 @@
+/*
+ * serve_bench.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ * Load test for photodb serve: each client connects once and sends requests
+ * one after another, taking the request lines given in turn, and the
+ * throughput and latency percentiles over all of them are reported.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+typedef std::chrono::steady_clock clock_type;
+
+bool option(const std::string& arg, const std::string& name, std::string& value)
+{
+	if(arg.compare(0, name.size() + 1, name + '=') != 0)
+		return false;
+	value = arg.substr(name.size() + 1);
+	return true;
+}
+
+int connect_to(const std::string& path)
+{
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(path.size() >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd != -1 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+struct client_t
+{
+	std::vector<uint64_t> latencies;	// ns
+	uint64_t bytes;
+	unsigned errors;
+	bool failed;
+
+	client_t()
+	 : bytes(0), errors(0), failed(false)
+	{
+	}
+};
+
+// Reads until buffer holds a whole answer, which is then removed from it.
+bool receive(int fd, std::string& buffer, client_t& client)
+{
+	char data[65536];
+	for(;;)
+	{
+		std::size_t eol = buffer.find('\n');
+		if(eol != std::string::npos)
+		{
+			if(buffer.compare(0, 3, "OK ") != 0)
+			{
+				++client.errors;
+				buffer.erase(0, eol + 1);
+				return true;
+			}
+
+			std::size_t size = std::stoull(buffer.substr(3, eol - 3));
+			if(buffer.size() >= eol + 1 + size)
+			{
+				client.bytes += size;
+				buffer.erase(0, eol + 1 + size);
+				return true;
+			}
+		}
+
+		ssize_t n = read(fd, data, sizeof(data));
+		if(n <= 0)
+			return false;
+		buffer.append(data, n);
+	}
+}
+
+void run(const std::string& path, const std::vector<std::string>& requests, unsigned offset, unsigned count, client_t& client)
+{
+	int fd = connect_to(path);
+	if(fd == -1)
+	{
+		client.failed = true;
+		return;
+	}
+
+	std::string buffer;
+	client.latencies.reserve(count);
+	for(unsigned i = 0; i < count; ++i)
+	{
+		const std::string line = requests[(offset + i) % requests.size()] + "\n";
+		auto start = clock_type::now();
+		if(write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()) || !receive(fd, buffer, client))
+		{
+			client.failed = true;
+			break;
+		}
+		client.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count());
+	}
+	close(fd);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> args(argv, argv+argc);
+
+	std::string path;
+	unsigned clients(4);
+	unsigned count(1000);
+	std::vector<std::string> requests;
+	for(size_t i = 1; i < args.size(); ++i)
+	{
+		std::string value;
+		if(option(args[i], "--socket", value))
+			path = value;
+		else if(option(args[i], "--clients", value))
+			clients = std::max(std::stoul(value), 1ul);
+		else if(option(args[i], "--requests", value))
+			count = std::stoul(value);
+		else
+			requests.push_back(args[i]);
+	}
+
+	if(path.empty() || requests.empty())
+	{
+		std::cerr << args[0] << " --socket=path [--clients=N] [--requests=N] request...\n";
+		std::cerr << "each request is one line of query options, e.g. \"--month=2019-07 --count\"\n";
+		return 1;
+	}
+
+	std::vector<client_t> results(clients);
+	std::vector<std::thread> threads;
+	auto start = clock_type::now();
+	for(unsigned i = 0; i < clients; ++i)
+		threads.emplace_back(run, std::cref(path), std::cref(requests), i, count, std::ref(results[i]));
+	for(auto& thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	std::vector<uint64_t> latencies;
+	uint64_t bytes(0);
+	unsigned errors(0);
+	for(auto& client : results)
+	{
+		if(client.failed)
+		{
+			std::cerr << path << ": connection failed\n";
+			return 1;
+		}
+		latencies.insert(latencies.end(), client.latencies.begin(), client.latencies.end());
+		bytes += client.bytes;
+		errors += client.errors;
+	}
+	if(latencies.empty())
+		return 0;
+	std::sort(latencies.begin(), latencies.end());
+
+	auto percentile = [&](double p)
+	{
+		return latencies[std::min<std::size_t>(latencies.size() * p, latencies.size() - 1)] / 1000.0;
+	};
+	std::cout << std::fixed << std::setprecision(1)
+			  << "requests\t" << latencies.size() << "\n"
+			  << "errors\t" << errors << "\n"
+			  << "qps\t" << latencies.size() / seconds << "\n"
+			  << "MB/s\t" << bytes / seconds / (1 << 20) << "\n"
+			  << "p50 us\t" << percentile(0.5) << "\n"
+			  << "p90 us\t" << percentile(0.9) << "\n"
+			  << "p99 us\t" << percentile(0.99) << "\n"
+			  << "max us\t" << latencies.back() / 1000.0 << "\n";
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * checkpoint.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "checkpoint.h"
+#include <tuple>
+
+namespace
+{
+
+// Commit after this many changes or this long, whichever comes first.
+const std::size_t batch_size = 1000;
+const std::chrono::seconds batch_time(5);
+
+}
+
+checkpoint_t::checkpoint_t(db_t& db)
+ : db(db),
+   insert_state{db, "INSERT INTO scan_state (rebuilt) VALUES (?)"},
+   insert_dir{db, "INSERT OR REPLACE INTO scan_dirs (path, parent, mtime, nlink, entries) VALUES (?, ?, ?, ?, ?)"},
+   insert_queued{db, "INSERT OR REPLACE INTO scan_queue (path, file_name, size, mtime, dev, ino) VALUES (?, ?, ?, ?, ?, ?)"},
+   remove_queued{db, "DELETE FROM scan_queue WHERE path = ? AND file_name = ?"},
+   uncommitted(0), open(false)
+{
+}
+
+bool checkpoint_t::interrupted(std::string& rebuilt)
+{
+	bool found(false);
+	db_t::statement_t<> select_state{db, "SELECT rebuilt FROM scan_state"};
+	auto x = [&rebuilt, &found](const std::tuple<std::string>& t)
+	{
+		rebuilt = std::get<0>(t);
+		found = true;
+	};
+	select_state.query<decltype(x), std::string>(x);
+	return found;
+}
+
+std::multimap<std::string, photo_t> checkpoint_t::queued()
+{
+	std::multimap<std::string, photo_t> photos;
+	db_t::statement_t<> select_queue{db, "SELECT path, file_name, size, mtime, dev, ino FROM scan_queue"};
+	auto x = [&photos](const std::tuple<std::string, std::string, int64_t, std::string, int64_t, int64_t>& t)
+	{
+		photo_t photo{std::get<1>(t), std::get<0>(t)};
+		photo.size = std::get<2>(t);
+		photo.mtime = timestamp_t{std::get<3>(t)};
+		photo.dev = std::get<4>(t);
+		photo.ino = std::get<5>(t);
+		photos.emplace(photo.path, photo);
+	};
+	select_queue.query<decltype(x), std::string, std::string, int64_t, std::string, int64_t, int64_t>(x);
+	return photos;
+}
+
+void checkpoint_t::start(const std::string& rebuilt)
+{
+	db.execute("BEGIN");
+	open = true;
+	db.execute("DELETE FROM scan_state");
+	db.execute("DELETE FROM scan_dirs");
+	db.execute("DELETE FROM scan_queue");
+	insert_state.execute(rebuilt);
+	commit();
+
+	db.execute("BEGIN");
+	open = true;
+}
+
+void checkpoint_t::walked(const dir_t& dir)
+{
+	insert_dir.execute(dir.path, dir.parent, dir.mtime, dir.nlink, dir.entries);
+	step();
+}
+
+void checkpoint_t::queue(const photo_t& photo)
+{
+	insert_queued.execute(photo.path, photo.file_name, photo.size, photo.mtime.str(), photo.dev, photo.ino);
+	step();
+}
+
+void checkpoint_t::done(const photo_t& photo)
+{
+	remove_queued.execute(photo.path, photo.file_name);
+	step();
+}
+
+void checkpoint_t::step()
+{
+	++uncommitted;
+	if(uncommitted < batch_size && std::chrono::steady_clock::now() - last_commit < batch_time)
+		return;
+
+	commit();
+	db.execute("BEGIN");
+	open = true;
+}
+
+void checkpoint_t::commit()
+{
+	if(!open)
+		return;
+
+	db.execute("COMMIT");
+	open = false;
+	uncommitted = 0;
+	last_commit = std::chrono::steady_clock::now();
+}
+
+void checkpoint_t::finish()
+{
+	commit();
+	db.execute("BEGIN");
+	open = true;
+	db.execute("DELETE FROM scan_state");
+	db.execute("DELETE FROM scan_dirs");
+	db.execute("DELETE FROM scan_queue");
+	commit();
+}
+
+checkpoint_t::~checkpoint_t()
+{
+	// Leaving early on an error keeps what the last batch recorded.
+	try
+	{
+		commit();
+	}
+	catch(const db_t::error&)
+	{
+	}
+}
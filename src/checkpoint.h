@@ -0,0 +1,66 @@
+/*
+ * checkpoint.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include "db.h"
+#include "dirs.h"
+#include "photo.h"
+
+/*
+ * Progress of a scan, kept in the db so an interrupted import can be resumed:
+ * the directories walked so far and the new files found in them that are
+ * still to be read. Everything the scan writes goes through one transaction
+ * that is committed every batch, so a kill loses at most the current batch.
+ */
+class checkpoint_t
+{
+private:
+	db_t& db;
+
+	db_t::statement_t<std::string> insert_state;
+	db_t::statement_t<std::string, std::string, int64_t, int64_t, int64_t> insert_dir;
+	db_t::statement_t<std::string, std::string, uint64_t, std::string, uint64_t, uint64_t> insert_queued;
+	db_t::statement_t<std::string, std::string> remove_queued;
+
+	std::size_t uncommitted;
+	std::chrono::steady_clock::time_point last_commit;
+	bool open;
+
+	void step();
+public:
+	explicit checkpoint_t(db_t& db);
+
+	checkpoint_t(const checkpoint_t&) = delete;
+	checkpoint_t& operator=(const checkpoint_t&) = delete;
+
+	// The rebuilt stamp of a scan that did not finish, if there is one.
+	bool interrupted(std::string& rebuilt);
+	// Files still to be read by the interrupted scan, by directory.
+	std::multimap<std::string, photo_t> queued();
+
+	// Forgets any previous checkpoint and opens the first batch.
+	void start(const std::string& rebuilt);
+
+	// A directory has been listed and its files matched or queued.
+	void walked(const dir_t& dir);
+	void queue(const photo_t& photo);
+	// A queued file has been stored.
+	void done(const photo_t& photo);
+
+	// Commits the open batch.
+	void commit();
+	// Commits and removes the checkpoint once the scan is complete.
+	void finish();
+
+	~checkpoint_t();
+};
+
+#endif /* CHECKPOINT_H_ */
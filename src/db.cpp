@@ -12,10 +12,12 @@ db_t::error::error(const std::string& what, int code)
 {
 }
 
-db_t::db_t(const std::string& filename)
+db_t::db_t(const std::string& filename, bool read_only)
  : db(nullptr)
 {
-	if(int res = sqlite3_open(filename.c_str(), &db) != SQLITE_OK)
+	// URIs let databases be attached read-only (file:...?mode=ro).
+	int flags = (read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) | SQLITE_OPEN_URI;
+	if(int res = sqlite3_open_v2(filename.c_str(), &db, flags, nullptr) != SQLITE_OK)
 	{
 		error ex{sqlite3_errmsg(db), res};
 		sqlite3_close(db);
@@ -8,6 +8,7 @@
 #ifndef DB_H_
 #define DB_H_
 #include "sqlite3.h"
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -35,6 +36,20 @@ public:
 		error(const std::string& what, int code);
 	};
 
+	// A text column in place; valid only until the next row.
+	struct text_t
+	{
+		const char* data;
+		std::size_t size;
+	};
+
+	// A blob column in place; valid only until the next row.
+	struct blob_t
+	{
+		const void* data;
+		std::size_t size;
+	};
+
 	template<typename... Args>
 	class statement_t
 	{
@@ -102,6 +117,18 @@ public:
 	    	const std::string::size_type n = sqlite3_column_bytes(stmt, col);
 	    	val = std::string(c, c+n);
 	    }
+	    void unpack_column_int(int col, text_t& val)
+	    {
+	    	val.data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+	    	val.size = sqlite3_column_bytes(stmt, col);
+	    	if(!val.data)
+	    		val.data = "";
+	    }
+	    void unpack_column_int(int col, blob_t& val)
+	    {
+	    	val.data = sqlite3_column_blob(stmt, col);
+	    	val.size = sqlite3_column_bytes(stmt, col);
+	    }
 
 	    void unpack_column(int)
 	    {
@@ -131,6 +158,14 @@ public:
 				throw error{sqlite3_errmsg(db), res};
 		}
 
+		// Binds parameter arg (from 1) of a statement whose parameters are
+		// only known at run time; it holds until bound again.
+		template <typename T>
+		void bind(int arg, const T& val)
+		{
+			bind_arg_int(arg, val);
+		}
+
 		template <typename Fn, typename... Res>
 		void query(Fn func, const Args &... args)
 		{
@@ -176,7 +211,8 @@ public:
 		}
 	};
 
-	db_t(const std::string& filename);
+	// A read only connection cannot create the db or write to it.
+	db_t(const std::string& filename, bool read_only = false);
 
 	db_t(const db_t&) = delete;
 	db_t& operator=(const db_t&) = delete;
@@ -0,0 +1,82 @@
+/*
+ * dirs.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "dirs.h"
+#include "db.h"
+#include <tuple>
+
+dir_t::dir_t()
+ : mtime(), nlink(), entries()
+{
+}
+
+dir_t::dir_t(const std::string& path, const std::string& parent, const struct stat& sb)
+ : path(path), parent(parent), mtime(sb.st_mtim.tv_sec * 1000000000LL + sb.st_mtim.tv_nsec), nlink(sb.st_nlink), entries()
+{
+}
+
+void dir_t::invalidate()
+{
+	mtime = -1;
+}
+
+dir_cache_t::dir_cache_t(db_t& db, const std::string& table)
+{
+	db_t::statement_t<> select_dirs{db, "SELECT path, parent, mtime, nlink, entries FROM " + table};
+
+	auto x = [this](const std::tuple<std::string, std::string, int64_t, int64_t, int64_t>& t)
+	{
+		dir_t dir;
+		std::tie(dir.path, dir.parent, dir.mtime, dir.nlink, dir.entries) = t;
+		children.emplace(dir.parent, dir.path);
+		dirs.emplace(dir.path, dir);
+	};
+	select_dirs.query<decltype(x), std::string, std::string, int64_t, int64_t, int64_t>(x);
+}
+
+const dir_t* dir_cache_t::unchanged(const dir_t& dir) const
+{
+	auto it = dirs.find(dir.path);
+	if(it == dirs.end())
+		return nullptr;
+
+	auto& cached = it->second;
+	if(cached.mtime != dir.mtime || cached.nlink != dir.nlink)
+		return nullptr;
+	return &cached;
+}
+
+std::vector<std::string> dir_cache_t::subdirs(const std::string& path) const
+{
+	std::vector<std::string> paths;
+	auto range = children.equal_range(path);
+	for(auto it = range.first; it != range.second; ++it)
+		paths.push_back(it->second);
+	return paths;
+}
+
+void dir_cache_t::store(db_t& db, const std::string& rebuilt, const std::vector<dir_t>& read, const std::vector<dir_t>& skipped)
+{
+	db_t::statement_t<std::string> clear_children{db, "DELETE FROM dirs WHERE parent = ?"};
+	db_t::statement_t<std::string, std::string, int64_t, int64_t, int64_t, std::string> insert_dir{db, "INSERT OR REPLACE INTO dirs VALUES (?, ?, ?, ?, ?, ?)"};
+	db_t::statement_t<std::string, std::string> touch_photos{db, "UPDATE photos SET rebuilt = ? WHERE path = ?"};
+
+	db.execute("BEGIN");
+
+	// Subdirectories of a re-read directory are only those seen this time.
+	for(auto& dir : read)
+		clear_children.execute(dir.path);
+	for(auto& dir : read)
+		insert_dir.execute(dir.path, dir.parent, dir.mtime, dir.nlink, dir.entries, rebuilt);
+	for(auto& dir : skipped)
+		insert_dir.execute(dir.path, dir.parent, dir.mtime, dir.nlink, dir.entries, rebuilt);
+
+	// Files in skipped directories were seen too, just not individually.
+	for(auto& dir : skipped)
+		touch_photos.execute(rebuilt, dir.path);
+
+	db.execute("COMMIT");
+}
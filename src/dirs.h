@@ -0,0 +1,55 @@
+/*
+ * dirs.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef DIRS_H_
+#define DIRS_H_
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+class db_t;
+
+struct dir_t
+{
+	std::string path;
+	std::string parent;
+
+	int64_t mtime;		// nanoseconds
+	int64_t nlink;
+	int64_t entries;	// regular files
+
+	dir_t();
+	dir_t(const std::string& path, const std::string& parent, const struct stat& sb);
+
+	// Still recorded under its parent, but never found unchanged, so the
+	// next scan lists it again.
+	void invalidate();
+};
+
+/*
+ * Directory state recorded by the previous scan.
+ * A directory whose mtime and link count are unchanged has the same entries
+ * it had then, so its files need not be listed or stat()ed again.
+ * Modifying a file in place does not touch the directory; a full scan is
+ * required to pick those up.
+ */
+class dir_cache_t
+{
+private:
+	std::map<std::string, dir_t> dirs;
+	std::multimap<std::string, std::string> children;
+public:
+	explicit dir_cache_t(db_t& db, const std::string& table = "dirs");
+
+	const dir_t* unchanged(const dir_t& dir) const;
+	std::vector<std::string> subdirs(const std::string& path) const;
+
+	static void store(db_t& db, const std::string& rebuilt, const std::vector<dir_t>& read, const std::vector<dir_t>& skipped);
+};
+
+#endif /* DIRS_H_ */
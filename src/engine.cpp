@@ -0,0 +1,519 @@
+/*
+ * engine.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "engine.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "ingest.h"
+#include "metrics.h"
+#include "uring.h"
+#include "util.h"
+
+namespace
+{
+
+template <typename T>
+class queue_t
+{
+private:
+	std::mutex m;
+	std::condition_variable cv;
+	std::deque<T> items;
+public:
+	void push(const T& item)
+	{
+		std::lock_guard<std::mutex> lock(m);
+		items.push_back(item);
+		cv.notify_one();
+	}
+
+	T pop()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [this]{ return !items.empty(); });
+		T item = items.front();
+		items.pop_front();
+		return item;
+	}
+};
+
+unsigned worker_count(const read_options& options)
+{
+	return std::max(options.threads, 1u);
+}
+
+// The first exception from any of several threads.
+class first_error_t
+{
+private:
+	std::mutex m;
+	std::exception_ptr error;
+public:
+	// Call from a catch block.
+	void set()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		if(!error)
+			error = std::current_exception();
+	}
+
+	explicit operator bool()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		return static_cast<bool>(error);
+	}
+
+	void rethrow()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		if(error)
+			std::rethrow_exception(error);
+	}
+};
+
+// Each worker takes the next photo and reads it with read_file().
+void read_pool(const std::vector<photo_t*>& photos, const read_options& options, queue_t<photo_t*>& done)
+{
+	read_options single = options;
+	if(single.mode == read_options::uring)
+		single.mode = read_options::map;
+
+	// After a failure the other workers stop taking photos.
+	std::atomic<size_t> next(0);
+	first_error_t error;
+	std::vector<std::thread> workers;
+	for(unsigned i = 0; i < worker_count(options); ++i)
+	{
+		workers.emplace_back([&]
+		{
+			try
+			{
+				for(size_t n; (n = next++) < photos.size(); )
+				{
+					auto& photo = *photos[n];
+					exif(photo, !options.thumbnails.empty());
+					checksum(photo, single);
+					done.push(&photo);
+				}
+			}
+			catch(...)
+			{
+				error.set();
+				next = photos.size();
+			}
+		});
+	}
+
+	for(auto& worker : workers)
+		worker.join();
+	error.rethrow();
+}
+
+const uint64_t poll_tag = ~0ULL;
+const unsigned stop_slot = ~0U;
+
+class ring_reader_t
+{
+private:
+	struct slot_t
+	{
+		photo_t* photo;
+		int fd;
+		uint64_t offset;
+		int result;
+		std::unique_ptr<hasher_t> hasher;
+		char* buffer;
+
+		// hashing time so far, recorded once the file is done.
+		uint64_t start;
+		uint64_t wall;
+		uint64_t cpu;
+	};
+
+	const std::vector<photo_t*>& photos;
+	const read_options& options;
+	queue_t<photo_t*>& done;
+
+	// Outlives the ring, which may still be reading into it when a failure
+	// unwinds.
+	std::unique_ptr<char, void(*)(void*)> memory;
+	uring_t ring;
+	int event;
+	std::vector<slot_t> slots;
+
+	// From a worker; no more photos are started after one.
+	first_error_t error;
+
+	// Slots with a completed read, for the workers.
+	queue_t<unsigned> ready;
+	// Slots the workers have finished with, for the ring thread.
+	std::mutex returned_m;
+	std::vector<unsigned> returned;
+
+	size_t next;
+	unsigned active;
+
+	// A free submission entry, submitting what is queued to make room.
+	io_uring_sqe* next_sqe()
+	{
+		auto sqe = ring.sqe();
+		if(!sqe)
+		{
+			ring.submit(0);
+			sqe = ring.sqe();
+		}
+		throw_if(!sqe, "io_uring submission queue full");
+		return sqe;
+	}
+
+	void submit_read(unsigned index)
+	{
+		auto& s = slots[index];
+		auto sqe = next_sqe();
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->flags = IOSQE_FIXED_FILE;
+		sqe->fd = index;
+		sqe->addr = reinterpret_cast<uintptr_t>(s.buffer);
+		sqe->len = options.buffer;
+		sqe->off = s.offset;
+		sqe->buf_index = index;
+		sqe->user_data = index;
+	}
+
+	void arm_poll()
+	{
+		auto sqe = next_sqe();
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->fd = event;
+		sqe->poll_events = POLLIN;
+		sqe->user_data = poll_tag;
+	}
+
+	// Loads the next photo into a slot; false if there are none left.
+	bool start(unsigned index)
+	{
+		auto& s = slots[index];
+		while(next < photos.size() && !error)
+		{
+			auto photo = photos[next++];
+			int fd = open(photo->full_filename().c_str(), O_RDONLY);
+			if(fd == -1)
+			{
+				// Nothing to hash; exif() will report the same problem.
+				exif(*photo, !options.thumbnails.empty());
+				done.push(photo);
+				continue;
+			}
+
+			ring.update_file(index, fd);
+			s.photo = photo;
+			s.fd = fd;
+			s.offset = 0;
+			s.hasher = hasher_t::create(options.hash);
+			s.start = metrics_t::wall_now();
+			s.wall = 0;
+			s.cpu = 0;
+			submit_read(index);
+			++active;
+			return true;
+		}
+		return false;
+	}
+
+	void give_back(unsigned index)
+	{
+		std::lock_guard<std::mutex> lock(returned_m);
+		returned.push_back(index);
+		uint64_t one = 1;
+		if(write(event, &one, sizeof(one)) != sizeof(one))
+			std::cerr << "eventfd: " << strerror(errno) << "\n";
+	}
+
+	// Hashes a completed read; the photo if that was the end of it.
+	photo_t* hash_read(unsigned index)
+	{
+		auto& s = slots[index];
+		photo_t* finished = nullptr;
+
+		if(s.result < 0)
+		{
+			std::cerr << s.photo->full_filename() << ": " << strerror(-s.result) << "\n";
+			finished = s.photo;
+		}
+		else
+		{
+			uint64_t wall = metrics_t::wall_now();
+			uint64_t cpu = metrics_t::cpu_now();
+			s.hasher->update(s.buffer, s.result);
+			s.offset += s.result;
+			s.wall += metrics_t::wall_now() - wall;
+			s.cpu += metrics_t::cpu_now() - cpu;
+
+			// A short read is the end of the file.
+			if(static_cast<std::size_t>(s.result) < options.buffer)
+			{
+				metrics().record(metrics_t::hash, s.start, s.wall, s.cpu, s.offset);
+				finished = s.photo;
+				if(s.offset != s.photo->size)
+				{
+					std::cerr << s.photo->full_filename() << ": changed while reading\n";
+				}
+				else
+				{
+					s.photo->checksum = s.hasher->final();
+					s.photo->hash = hash_name(options.hash);
+				}
+			}
+		}
+		return finished;
+	}
+
+	void worker()
+	{
+		for(unsigned index; (index = ready.pop()) != stop_slot; )
+		{
+			auto& s = slots[index];
+			photo_t* finished = nullptr;
+			try
+			{
+				finished = hash_read(index);
+			}
+			catch(...)
+			{
+				// The slot goes back empty, so the ring thread closes it.
+				error.set();
+				s.photo = nullptr;
+			}
+
+			if(finished)
+				s.photo = nullptr;
+			give_back(index);
+
+			if(finished)
+			{
+				try
+				{
+					exif(*finished, !options.thumbnails.empty());
+					done.push(finished);
+				}
+				catch(...)
+				{
+					error.set();
+				}
+			}
+		}
+	}
+
+public:
+	ring_reader_t(const std::vector<photo_t*>& photos, const read_options& options, queue_t<photo_t*>& done)
+	 : photos(photos), options(options), done(done), memory(nullptr, free), ring(options.depth + 1), event(-1), next(), active()
+	{
+		event = eventfd(0, EFD_CLOEXEC);
+		throw_if(event == -1, strerror(errno));
+
+		void* p;
+		if(posix_memalign(&p, 4096, options.depth * options.buffer) != 0)
+		{
+			close(event);
+			throw std::runtime_error("Unable to allocate read buffers");
+		}
+		memory.reset(static_cast<char*>(p));
+
+		std::vector<iovec> iovs(options.depth);
+		slots.resize(options.depth);
+		for(unsigned i = 0; i < options.depth; ++i)
+		{
+			slots[i].photo = nullptr;
+			slots[i].fd = -1;
+			slots[i].buffer = memory.get() + i * options.buffer;
+			iovs[i].iov_base = slots[i].buffer;
+			iovs[i].iov_len = options.buffer;
+		}
+
+		try
+		{
+			ring.register_buffers(iovs.data(), iovs.size());
+			ring.register_files(options.depth);
+		}
+		catch(...)
+		{
+			close(event);
+			throw;
+		}
+	}
+
+	// Throws the first exception from the ring or a worker, once the
+	// workers have stopped.
+	void run()
+	{
+		std::vector<std::thread> workers;
+		for(unsigned i = 0; i < worker_count(options); ++i)
+			workers.emplace_back(&ring_reader_t::worker, this);
+
+		auto stop_workers = [&]
+		{
+			for(size_t i = 0; i < workers.size(); ++i)
+				ready.push(stop_slot);
+			for(auto& worker : workers)
+				worker.join();
+		};
+
+		try
+		{
+			loop();
+		}
+		catch(...)
+		{
+			stop_workers();
+			throw;
+		}
+		stop_workers();
+		error.rethrow();
+	}
+
+	~ring_reader_t()
+	{
+		for(auto& s : slots)
+			if(s.fd != -1)
+				close(s.fd);
+		close(event);
+	}
+
+private:
+	// Keeps the slots reading until every photo has been started and done.
+	void loop()
+	{
+		for(unsigned i = 0; i < slots.size(); ++i)
+			start(i);
+		arm_poll();
+
+		while(active)
+		{
+			ring.submit(1);
+
+			bool woken(false);
+			ring.completions([&](const io_uring_cqe& cqe)
+			{
+				if(cqe.user_data == poll_tag)
+				{
+					woken = true;
+					return;
+				}
+				slots[cqe.user_data].result = cqe.res;
+				ready.push(cqe.user_data);
+			});
+
+			if(!woken)
+				continue;
+
+			uint64_t count;
+			if(read(event, &count, sizeof(count)) != sizeof(count))
+				std::cerr << "eventfd: " << strerror(errno) << "\n";
+
+			std::vector<unsigned> back;
+			{
+				std::lock_guard<std::mutex> lock(returned_m);
+				back.swap(returned);
+			}
+			arm_poll();
+
+			for(auto index : back)
+			{
+				auto& s = slots[index];
+				if(s.photo)
+				{
+					submit_read(index);
+					continue;
+				}
+
+				close(s.fd);
+				s.fd = -1;
+				--active;
+				start(index);
+			}
+		}
+	}
+};
+
+}
+
+void read_photos(const std::vector<photo_t*>& photos, const read_options& options, const std::function<void(photo_t&)>& done)
+{
+	// A null photo stands for a failure, in error.
+	queue_t<photo_t*> finished;
+	std::exception_ptr error;
+
+	std::thread reader([&]
+	{
+		try
+		{
+			if(options.mode == read_options::uring)
+			{
+				std::unique_ptr<ring_reader_t> ring;
+				try
+				{
+					ring.reset(new ring_reader_t(photos, options, finished));
+				}
+				catch(const std::runtime_error& ex)
+				{
+					std::cerr << ex.what() << "; reading with threads\n";
+				}
+
+				if(ring)
+				{
+					ring->run();
+					return;
+				}
+			}
+			read_pool(photos, options, finished);
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+			finished.push(nullptr);
+		}
+	});
+
+	// The db is only touched from this thread. Whatever fails, the reader
+	// is joined before the exception goes on.
+	std::exception_ptr failed;
+	for(size_t n = 0; n < photos.size(); ++n)
+	{
+		photo_t* photo = finished.pop();
+		if(!photo)
+			break;
+		if(failed)
+			continue;
+		try
+		{
+			done(*photo);
+		}
+		catch(...)
+		{
+			failed = std::current_exception();
+		}
+	}
+
+	reader.join();
+	if(error)
+		std::rethrow_exception(error);
+	if(failed)
+		std::rethrow_exception(failed);
+}
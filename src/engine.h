@@ -0,0 +1,25 @@
+/*
+ * engine.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+#include <functional>
+#include <vector>
+#include "photo.h"
+#include "reader.h"
+
+/*
+ * Hashes and reads the exif of many photos at once, handing each back to
+ * the calling thread (in completion order) once done. One that could not
+ * be hashed comes back with its checksum empty.
+ *
+ * With read_options::uring one thread keeps up to depth reads in flight
+ * across files and hands the completed buffers to the workers. Otherwise,
+ * or where the kernel has no io_uring, each worker reads its own files.
+ */
+void read_photos(const std::vector<photo_t*>& photos, const read_options& options, const std::function<void(photo_t&)>& done);
+
+#endif /* ENGINE_H_ */
@@ -0,0 +1,250 @@
+/*
+ * events.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "events.h"
+#include <cstring>
+#include <tuple>
+#include <vector>
+#include "output.h"
+#include "timestamp.h"
+
+namespace
+{
+
+struct event_t
+{
+	int64_t id;
+	std::string start;
+	std::string end;
+	int64_t first;	// seconds of start and end
+	int64_t last;
+	int64_t photos;
+
+	event_t()
+	 : id(), first(), last(), photos()
+	{
+	}
+};
+
+// Dated photos only: unknown times are stored as zeros.
+const char* const dated = "timestamp >= '0001'";
+
+// Splits timestamps, given in order, into events.
+struct grouping_t
+{
+	int64_t gap;
+	std::vector<event_t> events;
+	bool ordered;	// false once one came before the one ahead of it
+
+	char day[10];	// yyyy-mm-dd of the last one
+	int64_t midnight;
+
+	explicit grouping_t(int64_t gap)
+	 : gap(gap), ordered(true), day(), midnight()
+	{
+	}
+
+	// Seconds since midnight of the hh:mm:ss at 11, or -1.
+	static int64_t time_of_day(const char* ts)
+	{
+		int64_t s(0);
+		for(int i : {11, 14, 17})
+		{
+			unsigned tens = ts[i] - '0', units = ts[i + 1] - '0';
+			if(tens > 9 || units > 9)
+				return -1;
+			s = s * 60 + tens * 10 + units;
+		}
+		return s;
+	}
+
+	void add(const char* ts, std::size_t size)
+	{
+		// Most share their day with the one before, so only the time of
+		// day needs reading.
+		int64_t s = size >= 19 && !memcmp(ts, day, sizeof(day)) ? time_of_day(ts) : INT64_MIN;
+		if(s >= 0)
+		{
+			s += midnight;
+			if(s < events.back().last)
+				ordered = false;
+		}
+		else
+		{
+			s = timestamp_seconds(ts, size);
+			if(s == INT64_MIN)
+				return;
+			memcpy(day, ts, sizeof(day));
+			midnight = s - time_of_day(ts);
+
+			// In the order of the index, which a day past the end of its
+			// month (as some cameras write) need not keep in seconds.
+			if(!events.empty() && events.back().end.compare(0, std::string::npos, ts, size) > 0)
+				ordered = false;
+		}
+
+		if(events.empty() || s - events.back().last > gap)
+		{
+			events.emplace_back();
+			events.back().start.assign(ts, size);
+			events.back().first = s;
+		}
+		event_t& event = events.back();
+		event.end.assign(ts, size);
+		event.last = s;
+		++event.photos;
+	}
+};
+
+void group_step(sqlite3_context* context, int, sqlite3_value** argv)
+{
+	auto ts = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+	if(ts)
+		static_cast<grouping_t*>(sqlite3_user_data(context))->add(ts, sqlite3_value_bytes(argv[0]));
+}
+
+void group_final(sqlite3_context* context)
+{
+	sqlite3_result_int(context, static_cast<grouping_t*>(sqlite3_user_data(context))->ordered);
+}
+
+/*
+ * Groups the dated photos as SQLite walks the timestamp index, in an
+ * aggregate rather than a row at a time, which takes about half as long.
+ * The order of such a walk is not promised, so it is checked; if it fails
+ * the photos are fetched again sorted.
+ */
+void group(db_t& db, grouping_t& grouping)
+{
+	if(int res = sqlite3_create_function(db, "group_events", 1, SQLITE_UTF8, &grouping, nullptr, group_step, group_final) != SQLITE_OK)
+		throw db_t::error{sqlite3_errmsg(db), res};
+
+	bool ordered(false);
+	{
+		db_t::statement_t<> walk{db, std::string("SELECT group_events(timestamp) FROM photos INDEXED BY photos_timestamp_idx WHERE ") + dated};
+		auto x = [&ordered](const std::tuple<int>& t)
+		{
+			ordered = std::get<0>(t);
+		};
+		walk.query<decltype(x), int>(x);
+	}
+	sqlite3_create_function(db, "group_events", 1, SQLITE_UTF8, nullptr, nullptr, nullptr, nullptr);
+	if(ordered)
+		return;
+
+	grouping = grouping_t(grouping.gap);
+	db_t::statement_t<> select_timestamps{db, std::string("SELECT timestamp FROM photos WHERE ") + dated + " ORDER BY timestamp"};
+	auto x = [&grouping](const std::tuple<db_t::text_t>& t)
+	{
+		grouping.add(std::get<0>(t).data, std::get<0>(t).size);
+	};
+	select_timestamps.query<decltype(x), db_t::text_t>(x);
+}
+
+}
+
+event_options::event_options()
+ : gap(2 * 60 * 60), list(false)
+{
+}
+
+bool events_db(db_t& db, const event_options& options)
+{
+	if(!options.list)
+	{
+		db_t::statement_t<std::string, std::string, int64_t, int64_t, int64_t> insert_event{db, "INSERT INTO events (start, end, first, last, photos) VALUES (?, ?, ?, ?, ?)"};
+		db_t::statement_t<int64_t> insert_state{db, "INSERT INTO event_state (gap) VALUES (?)"};
+
+		db.execute("BEGIN");
+		db.execute("DELETE FROM events");
+		db.execute("DELETE FROM event_state");
+		insert_state.execute(options.gap);
+
+		grouping_t grouping(options.gap);
+		group(db, grouping);
+		for(auto& event : grouping.events)
+			insert_event.execute(event.start, event.end, event.first, event.last, event.photos);
+
+		db.execute("COMMIT");
+	}
+
+	db_t::statement_t<> select_events{db, "SELECT id, start, end, photos FROM events ORDER BY first"};
+	writer_t out(stdout);
+	auto y = [&out](const std::tuple<int64_t, db_t::text_t, db_t::text_t, int64_t>& t)
+	{
+		out.put(std::get<0>(t)).put('\t');
+		out.put(std::get<1>(t).data, std::get<1>(t).size).put('\t');
+		out.put(std::get<2>(t).data, std::get<2>(t).size).put('\t');
+		out.put(std::get<3>(t)).put('\n');
+	};
+	select_events.query<decltype(y), int64_t, db_t::text_t, db_t::text_t, int64_t>(y);
+	return true;
+}
+
+events_t::events_t(db_t& db)
+ : gap(),
+   select_before{db, "SELECT id, start, end, first, last, photos FROM events WHERE first <= ? ORDER BY first DESC LIMIT 1"},
+   select_after{db, "SELECT id, start, end, first, last, photos FROM events WHERE first > ? ORDER BY first LIMIT 1"},
+   insert_event{db, "INSERT INTO events (start, end, first, last, photos) VALUES (?, ?, ?, ?, ?)"},
+   update_event{db, "UPDATE events SET start = ?, end = ?, first = ?, last = ?, photos = ? WHERE id = ?"},
+   delete_event{db, "DELETE FROM events WHERE id = ?"}
+{
+	db_t::statement_t<> select_state{db, "SELECT gap FROM event_state"};
+	auto x = [this](const std::tuple<int64_t>& t)
+	{
+		gap = std::get<0>(t);
+	};
+	select_state.query<decltype(x), int64_t>(x);
+}
+
+void events_t::add(const std::string& timestamp)
+{
+	if(!gap)
+		return;
+
+	int64_t s = timestamp_seconds(timestamp.data(), timestamp.size());
+	if(s == INT64_MIN)
+		return;
+
+	// Events are more than gap apart, so at most the one before and the one
+	// after can be within gap of a new photo.
+	event_t before, after;
+	auto x = [](event_t& event)
+	{
+		return [&event](const std::tuple<int64_t, std::string, std::string, int64_t, int64_t, int64_t>& t)
+		{
+			std::tie(event.id, event.start, event.end, event.first, event.last, event.photos) = t;
+		};
+	};
+	auto b = x(before);
+	select_before.query<decltype(b), int64_t, std::string, std::string, int64_t, int64_t, int64_t>(b, s);
+	auto a = x(after);
+	select_after.query<decltype(a), int64_t, std::string, std::string, int64_t, int64_t, int64_t>(a, s);
+
+	bool join_before = before.photos && s - before.last <= gap;
+	bool join_after = after.photos && after.first - s <= gap;
+
+	if(join_before && join_after)
+	{
+		update_event.execute(before.start, after.end, before.first, after.last, before.photos + after.photos + 1, before.id);
+		delete_event.execute(after.id);
+	}
+	else if(join_before)
+	{
+		if(s > before.last)
+			update_event.execute(before.start, timestamp, before.first, s, before.photos + 1, before.id);
+		else
+			update_event.execute(before.start, before.end, before.first, before.last, before.photos + 1, before.id);
+	}
+	else if(join_after)
+	{
+		update_event.execute(timestamp, after.end, s, after.last, after.photos + 1, after.id);
+	}
+	else
+	{
+		insert_event.execute(timestamp, timestamp, s, s, 1);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ * events.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+#include <cstdint>
+#include <string>
+#include "db.h"
+
+struct event_options
+{
+	// seconds without a photo that end an event.
+	int64_t gap;
+
+	// print the stored events rather than grouping again.
+	bool list;
+
+	event_options();
+};
+
+/*
+ * Groups the dated photos into events: runs of photos each taken within gap
+ * of the one before. Each row of events holds the first and last timestamp
+ * of one, so its photos are a range of the timestamp index; see
+ * query_options::event.
+ */
+bool events_db(db_t& db, const event_options& options);
+
+/*
+ * Keeps the events up to date as photos are added, once events_db() has
+ * grouped them: a new photo joins the event within gap of it, extending it,
+ * or bridges the two either side of it, or starts one of its own.
+ * Removing photos leaves events as they were until they are grouped again.
+ */
+class events_t
+{
+private:
+	int64_t gap;	// 0 while there are no events to maintain
+
+	db_t::statement_t<int64_t> select_before;
+	db_t::statement_t<int64_t> select_after;
+	db_t::statement_t<std::string, std::string, int64_t, int64_t, int64_t> insert_event;
+	db_t::statement_t<std::string, std::string, int64_t, int64_t, int64_t, int64_t> update_event;
+	db_t::statement_t<int64_t> delete_event;
+public:
+	explicit events_t(db_t& db);
+
+	void add(const std::string& timestamp);
+};
+
+#endif /* EVENTS_H_ */
@@ -0,0 +1,135 @@
+/*
+ * export.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "export.h"
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include "output.h"
+
+namespace
+{
+
+typedef db_t::text_t text_t;
+
+const char* const columns[] = {"path", "file_name", "size", "mtime", "timestamp", "checksum", "hash", "pixel_size", "exif_size"};
+const size_t column_count = sizeof(columns) / sizeof(*columns);
+
+typedef std::tuple<text_t, text_t, int64_t, text_t, text_t, text_t, text_t, text_t, text_t> row_t;
+
+// Text column i of a row; size is the only other.
+const text_t& column(const row_t& row, size_t i)
+{
+	switch(i)
+	{
+		case 0: return std::get<0>(row);
+		case 1: return std::get<1>(row);
+		case 3: return std::get<3>(row);
+		case 4: return std::get<4>(row);
+		case 5: return std::get<5>(row);
+		case 6: return std::get<6>(row);
+		case 7: return std::get<7>(row);
+		default: return std::get<8>(row);
+	}
+}
+
+void object(writer_t& out, const row_t& row)
+{
+	out.put('{');
+	for(size_t i = 0; i < column_count; ++i)
+	{
+		if(i)
+			out.put(',');
+		out.put('"').put(columns[i], strlen(columns[i])).put("\":", 2);
+		if(i == 2)
+			out.put(std::get<2>(row));
+		else
+			out.json(column(row, i).data, column(row, i).size);
+	}
+	out.put('}');
+}
+
+}
+
+export_options::export_options()
+ : format(ndjson)
+{
+}
+
+bool parse_export_format(const std::string& s, export_options::format_t& format)
+{
+	if(s == "ndjson")
+		format = export_options::ndjson;
+	else if(s == "json")
+		format = export_options::json;
+	else if(s == "csv")
+		format = export_options::csv;
+	else
+		return false;
+	return true;
+}
+
+bool export_db(db_t& db, const std::vector<std::string>& roots, const export_options& options)
+{
+	const auto format = options.format;
+	query_params_t params;
+	db_t::statement_t<> select{db, "SELECT path, file_name, size, mtime, timestamp, checksum, hash, pixel_size, exif_size FROM photos" + query_where(roots, options.query, params)};
+	params.bind(select);
+
+	writer_t out(stdout, 1 << 20);
+	bool first(true);
+
+	if(format == export_options::csv)
+	{
+		for(size_t i = 0; i < column_count; ++i)
+			out.put(i ? "," : "", i ? 1 : 0).put(columns[i], strlen(columns[i]));
+		out.put('\n');
+	}
+	else if(format == export_options::json)
+	{
+		out.put('[');
+	}
+
+	auto x = [&](const row_t& row)
+	{
+		switch(format)
+		{
+			case export_options::ndjson:
+				object(out, row);
+				out.put('\n');
+				break;
+			case export_options::json:
+				out.put(first ? "\n" : ",\n", first ? 1 : 2);
+				object(out, row);
+				break;
+			case export_options::csv:
+				for(size_t i = 0; i < column_count; ++i)
+				{
+					if(i)
+						out.put(',');
+					if(i == 2)
+						out.put(std::get<2>(row));
+					else
+						out.csv(column(row, i).data, column(row, i).size);
+				}
+				out.put('\n');
+				break;
+		}
+		first = false;
+	};
+	select.query<decltype(x), text_t, text_t, int64_t, text_t, text_t, text_t, text_t, text_t, text_t>(x);
+
+	if(format == export_options::json)
+		out.put(first ? "]\n" : "\n]\n", first ? 2 : 3);
+
+	// A full disk or a closed pipe should not pass for a complete export.
+	if(int error = out.finish())
+	{
+		std::cerr << "export: " << strerror(error) << "\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,35 @@
+/*
+ * export.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef EXPORT_H_
+#define EXPORT_H_
+#include <string>
+#include <vector>
+#include "db.h"
+#include "query.h"
+
+struct export_options
+{
+	enum format_t
+	{
+		ndjson,	// one object per line
+		json,	// one array of objects
+		csv		// with a header row
+	} format;
+
+	// which photos.
+	query_options query;
+
+	export_options();
+};
+
+// Parses ndjson, json or csv; false if unknown.
+bool parse_export_format(const std::string& s, export_options::format_t& format);
+
+// Writes the matching photos to stdout as they come off the db.
+bool export_db(db_t& db, const std::vector<std::string>& roots, const export_options& options);
+
+#endif /* EXPORT_H_ */
@@ -0,0 +1,53 @@
+/*
+ * extent.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "extent.h"
+#include <tuple>
+
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+bool extent_key::operator<(const extent_key& o) const
+{
+	return std::make_tuple(!mapped, offset) < std::make_tuple(!o.mapped, o.offset);
+}
+
+extent_key physical_offset(const std::string& filename, uint64_t ino)
+{
+	extent_key key{false, ino};
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+		return key;
+
+	alignas(fiemap) char buf[sizeof(fiemap) + sizeof(fiemap_extent)] = {};
+	auto fm = reinterpret_cast<fiemap*>(buf);
+	fm->fm_start = 0;
+	fm->fm_length = FIEMAP_MAX_OFFSET;
+	fm->fm_extent_count = 1;
+
+	if(ioctl(fd, FS_IOC_FIEMAP, fm) == 0 && fm->fm_mapped_extents > 0)
+	{
+		key.mapped = true;
+		key.offset = fm->fm_extents[0].fe_physical;
+	}
+
+	close(fd);
+	return key;
+}
+
+void prefetch(const std::string& filename, uint64_t size)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+		return;
+
+	posix_fadvise(fd, 0, size, POSIX_FADV_WILLNEED);
+	close(fd);
+}
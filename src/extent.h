@@ -0,0 +1,30 @@
+/*
+ * extent.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef EXTENT_H_
+#define EXTENT_H_
+#include <cstdint>
+#include <string>
+
+/*
+ * Where a file starts on disk, for ordering reads on spinning disks.
+ * Uses the first extent reported by FIEMAP; files the filesystem cannot map
+ * (or that are empty) sort after those it can, by inode number.
+ */
+struct extent_key
+{
+	bool mapped;
+	uint64_t offset;
+
+	bool operator<(const extent_key& o) const;
+};
+
+extent_key physical_offset(const std::string& filename, uint64_t ino);
+
+// Asks the kernel to start reading a file into the page cache.
+void prefetch(const std::string& filename, uint64_t size);
+
+#endif /* EXTENT_H_ */
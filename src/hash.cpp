@@ -0,0 +1,158 @@
+/*
+ * hash.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "hash.h"
+#include <cstdint>
+#include "sha1.h"
+
+#ifdef HAVE_XXHASH
+#include <xxhash.h>
+#endif
+
+#ifdef HAVE_BLAKE3
+#include <blake3.h>
+#endif
+
+namespace
+{
+
+std::string hex(const unsigned char* data, std::size_t length)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string s(length * 2, '0');
+	for(std::size_t i = 0; i < length; ++i)
+	{
+		s[i * 2] = digits[data[i] >> 4];
+		s[i * 2 + 1] = digits[data[i] & 0xf];
+	}
+	return s;
+}
+
+class sha1_hasher_t : public hasher_t
+{
+private:
+	::sha1::context ctx;
+public:
+	sha1_hasher_t()
+	{
+		::sha1::init(ctx);
+	}
+
+	void update(const void* data, std::size_t length) override
+	{
+		::sha1::update(ctx, data, length);
+	}
+
+	std::string final() override
+	{
+		unsigned char hash[20];
+		::sha1::final(ctx, hash);
+		return hex(hash, sizeof(hash));
+	}
+};
+
+#ifdef HAVE_XXHASH
+class xxh3_hasher_t : public hasher_t
+{
+private:
+	std::unique_ptr<XXH3_state_t, XXH_errorcode(*)(XXH3_state_t*)> state;
+public:
+	xxh3_hasher_t()
+	 : state(XXH3_createState(), XXH3_freeState)
+	{
+		XXH3_128bits_reset(state.get());
+	}
+
+	void update(const void* data, std::size_t length) override
+	{
+		XXH3_128bits_update(state.get(), data, length);
+	}
+
+	std::string final() override
+	{
+		XXH128_canonical_t canonical;
+		XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(state.get()));
+		return hex(canonical.digest, sizeof(canonical.digest));
+	}
+};
+#endif
+
+#ifdef HAVE_BLAKE3
+class blake3_hasher_t : public hasher_t
+{
+private:
+	blake3_hasher hasher;
+public:
+	blake3_hasher_t()
+	{
+		blake3_hasher_init(&hasher);
+	}
+
+	void update(const void* data, std::size_t length) override
+	{
+		blake3_hasher_update(&hasher, data, length);
+	}
+
+	std::string final() override
+	{
+		uint8_t hash[BLAKE3_OUT_LEN];
+		blake3_hasher_finalize(&hasher, hash, BLAKE3_OUT_LEN);
+		return hex(hash, sizeof(hash));
+	}
+};
+#endif
+
+}
+
+hasher_t::~hasher_t()
+{
+}
+
+std::unique_ptr<hasher_t> hasher_t::create(algorithm_t algorithm)
+{
+	switch(algorithm)
+	{
+		case sha1:
+			return std::unique_ptr<hasher_t>(new sha1_hasher_t);
+#ifdef HAVE_XXHASH
+		case xxh3_128:
+			return std::unique_ptr<hasher_t>(new xxh3_hasher_t);
+#endif
+#ifdef HAVE_BLAKE3
+		case blake3:
+			return std::unique_ptr<hasher_t>(new blake3_hasher_t);
+#endif
+		default:
+			return nullptr;
+	}
+}
+
+const char* hash_name(hasher_t::algorithm_t algorithm)
+{
+	switch(algorithm)
+	{
+		case hasher_t::sha1:
+			return "sha1";
+		case hasher_t::xxh3_128:
+			return "xxh3-128";
+		case hasher_t::blake3:
+			return "blake3";
+	}
+	return "";
+}
+
+bool parse_hash(const std::string& s, hasher_t::algorithm_t& algorithm)
+{
+	for(auto a : {hasher_t::sha1, hasher_t::xxh3_128, hasher_t::blake3})
+	{
+		if(s == hash_name(a) && hasher_t::create(a))
+		{
+			algorithm = a;
+			return true;
+		}
+	}
+	return false;
+}
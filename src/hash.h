@@ -0,0 +1,43 @@
+/*
+ * hash.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef HASH_H_
+#define HASH_H_
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*
+ * Incremental content hash. The algorithm a checksum was taken with is stored
+ * next to it, so rows hashed differently can share a db.
+ */
+class hasher_t
+{
+public:
+	enum algorithm_t
+	{
+		sha1,
+		xxh3_128,	// fast, not cryptographic; needs libxxhash
+		blake3		// needs libblake3
+	};
+
+	virtual ~hasher_t();
+
+	virtual void update(const void* data, std::size_t length) = 0;
+	// Hex digest of everything passed to update().
+	virtual std::string final() = 0;
+
+	// nullptr if this build lacks the algorithm.
+	static std::unique_ptr<hasher_t> create(algorithm_t algorithm);
+};
+
+// The name stored with checksums: sha1, xxh3-128 or blake3.
+const char* hash_name(hasher_t::algorithm_t algorithm);
+
+// Parses a hash name; false if unknown or not built in.
+bool parse_hash(const std::string& s, hasher_t::algorithm_t& algorithm);
+
+#endif /* HASH_H_ */
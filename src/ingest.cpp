@@ -0,0 +1,328 @@
+/*
+ * ingest.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "ingest.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <tuple>
+
+#include <exiv2/exiv2.hpp>
+
+#include <sys/stat.h>
+#include "metrics.h"
+#include "tree.h"
+
+bool stat(photo_t& photo)
+{
+	struct stat sb;
+	if(stat(photo.full_filename().c_str(), &sb) != 0)
+	{
+		std::cerr << photo.full_filename() << ": Unable to stat()\n";
+		return false;
+	}
+
+	photo.size = sb.st_size;
+	photo.mtime = timestamp_t{sb.st_mtime};
+	photo.dev = sb.st_dev;
+	photo.ino = sb.st_ino;
+	return true;
+}
+
+namespace
+{
+
+std::mutex xmp_m;
+
+void xmp_lock(void*, bool lock)
+{
+	if(lock)
+		xmp_m.lock();
+	else
+		xmp_m.unlock();
+}
+
+// The smallest JPEG preview; Exiv2 lists them smallest first.
+std::string smallest_preview(const Exiv2::Image& image)
+{
+	Exiv2::PreviewManager previews(image);
+	for(auto& properties : previews.getPreviewProperties())
+	{
+		if(properties.mimeType_ != "image/jpeg")
+			continue;
+
+		auto preview = previews.getPreviewImage(properties);
+		return std::string(reinterpret_cast<const char*>(preview.pData()), preview.size());
+	}
+	return {};
+}
+
+}
+
+void exif_initialize()
+{
+	Exiv2::XmpParser::initialize(xmp_lock);
+}
+
+void exif(photo_t& photo, bool preview)
+{
+	metrics_t::timer_t timer(metrics(), metrics_t::exif);
+	try
+	{
+		auto image = Exiv2::ImageFactory::open(photo.full_filename());
+
+		if (image.get())
+		{
+			image->readMetadata();
+			photo.pixel_size = {image->pixelWidth(), image->pixelHeight()};
+
+			Exiv2::ExifData &exifData = image->exifData();
+			if (!exifData.empty())
+			{
+				{
+					auto x = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelXDimension"));
+					if(x == exifData.end())
+						x = exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageWidth"));
+
+					auto y = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelYDimension"));
+					if(y == exifData.end())
+						y = exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageLength"));
+
+					if(x != exifData.end() && y != exifData.end())
+					{
+						photo.exif_size = {x->value().toLong(), y->value().toLong()};
+					}
+				}
+
+				auto datetime = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
+				if(datetime == exifData.end())
+					datetime = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTime"));
+				if(datetime == exifData.end())
+					datetime = exifData.findKey(Exiv2::ExifKey("Exif.Image.DateTime"));
+
+				if(datetime != exifData.end())
+				{
+					std::string timestamp = datetime->value().toString();
+					for(auto x = begin(timestamp); x != end(timestamp); )
+						if(*x == ' ')
+							x = timestamp.erase(x);
+						else
+							++x;
+					photo.timestamp = timestamp_t{timestamp};
+				}
+			}
+
+			if(preview)
+				photo.preview = smallest_preview(*image);
+		}
+	}
+	catch(const Exiv2::BasicError<char>& ex)
+	{
+		std::cerr << ex << "\n";
+	}
+	catch(const std::exception& ex)
+	{
+		// Such as a date timestamp_t cannot parse; the photo is kept without it.
+		std::cerr << photo.full_filename() << ": " << ex.what() << "\n";
+	}
+
+}
+
+bool checksum(photo_t& photo, const read_options& options)
+{
+	auto hasher = hasher_t::create(options.hash);
+	if(!photo.size)
+	{
+		photo.checksum = hasher->final();
+		photo.hash = hash_name(options.hash);
+		return true;
+	}
+
+	metrics_t::timer_t timer(metrics(), metrics_t::hash);
+	try
+	{
+		if(options.tree && photo.size >= options.tree)
+		{
+			std::string root;
+			uint64_t bytes = tree_hash(photo.full_filename(), photo.size, options, root, photo.chunks);
+			timer.add_bytes(bytes);
+			if(bytes != photo.size)
+			{
+				std::cerr << photo.full_filename() << ": changed while reading\n";
+				photo.chunks.clear();
+				return false;
+			}
+
+			photo.checksum = root;
+			photo.hash = tree_hash_name(options);
+			return true;
+		}
+
+		uint64_t bytes(0);
+		read_file(photo.full_filename(), options, [&hasher, &bytes](const void* data, std::size_t length)
+		{
+			hasher->update(data, length);
+			bytes += length;
+		});
+
+		timer.add_bytes(bytes);
+
+		// The row would pair this hash with the wrong size and mtime, so the
+		// photo is left unhashed and not stored.
+		if(bytes != photo.size)
+		{
+			std::cerr << photo.full_filename() << ": changed while reading\n";
+			return false;
+		}
+
+		photo.checksum = hasher->final();
+		photo.hash = hash_name(options.hash);
+		return true;
+	}
+	catch(const std::runtime_error& ex)
+	{
+		std::cerr << photo.full_filename() << ": " << ex.what() << "\n";
+		return false;
+	}
+}
+
+ingest_t::ingest_t(db_t& db, const timestamp_t& rebuilt, const read_options& options)
+ : rebuilt(rebuilt.str()), options(options),
+   insert_photo{db, "INSERT INTO photos (file_name, path, size, mtime, timestamp, checksum, pixel_size, exif_size, rebuilt, dev, ino, hash, thumbnail, thumbnail_size) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"},
+   photo_exists{db, "SELECT ROWID, timestamp, checksum, pixel_size, exif_size, hash, thumbnail, thumbnail_size FROM photos WHERE file_name = ? AND path = ? AND size = ? and mtime = ?"},
+   inode_exists{db, "SELECT ROWID, file_name, path, timestamp, checksum, pixel_size, exif_size, hash, thumbnail, thumbnail_size FROM photos WHERE dev = ? AND ino = ? AND size = ? AND mtime = ?"},
+   update_timestamp{db, "UPDATE photos set rebuilt = ?, dev = ?, ino = ? WHERE ROWID = ?"},
+   update_path{db, "UPDATE photos set file_name = ?, path = ?, rebuilt = ? WHERE ROWID = ?"},
+   insert_chunk{db, "INSERT OR REPLACE INTO chunks (hash, checksum, idx, offset, length, chunk) VALUES (?, ?, ?, ?, ?, ?)"},
+   events(db)
+{
+	if(!options.thumbnails.empty())
+		thumbnails.reset(new thumbnails_t(options.thumbnails, true));
+}
+
+bool ingest_t::lookup(photo_t& photo)
+{
+	bool found(false);
+	auto x = [&photo, &found](const std::tuple<int64_t, std::string, std::string, std::string, std::string, std::string, int64_t, int64_t>& t)
+	{
+		photo.id = std::get<0>(t);
+		photo.timestamp = timestamp_t{std::get<1>(t)};
+		photo.checksum = std::get<2>(t);
+		photo.pixel_size = {std::get<3>(t)};
+		photo.exif_size = {std::get<4>(t)};
+		photo.hash = std::get<5>(t);
+		photo.thumbnail = std::get<6>(t);
+		photo.thumbnail_size = std::get<7>(t);
+		found = true;
+	};
+	photo_exists.query<decltype(x), int64_t, std::string, std::string, std::string, std::string, std::string, int64_t, int64_t>(x, photo.file_name, photo.path, photo.size, photo.mtime.str());
+	return found;
+}
+
+void ingest_t::touch(const photo_t& photo)
+{
+	update_timestamp.execute(rebuilt, photo.dev, photo.ino, photo.id);
+}
+
+bool ingest_t::relink(photo_t& photo)
+{
+	if(!photo.ino)
+		return false;
+
+	bool found(false);
+	bool linked(false);
+	auto x = [&photo, &found, &linked](const std::tuple<int64_t, std::string, std::string, std::string, std::string, std::string, std::string, std::string, int64_t, int64_t>& t)
+	{
+		if(found)
+			return;
+
+		photo_t prev{std::get<1>(t), std::get<2>(t)};
+		photo.id = std::get<0>(t);
+		photo.timestamp = timestamp_t{std::get<3>(t)};
+		photo.checksum = std::get<4>(t);
+		photo.pixel_size = {std::get<5>(t)};
+		photo.exif_size = {std::get<6>(t)};
+		photo.hash = std::get<7>(t);
+		photo.thumbnail = std::get<8>(t);
+		photo.thumbnail_size = std::get<9>(t);
+		found = true;
+
+		// Still present under the old name, so this is another link to it.
+		struct stat sb;
+		linked = ::stat(prev.full_filename().c_str(), &sb) == 0 && sb.st_dev == photo.dev && sb.st_ino == photo.ino;
+	};
+	inode_exists.query<decltype(x), int64_t, std::string, std::string, std::string, std::string, std::string, std::string, std::string, int64_t, int64_t>(x, photo.dev, photo.ino, photo.size, photo.mtime.str());
+
+	if(!found)
+		return false;
+
+	if(linked)
+		store(photo);
+	else
+		update_path.execute(photo.file_name, photo.path, rebuilt, photo.id);
+	return true;
+}
+
+bool ingest_t::read(photo_t& photo)
+{
+	exif(photo, thumbnails != nullptr);
+	return checksum(photo, options);
+}
+
+bool ingest_t::insert(photo_t& photo)
+{
+	if(!read(photo))
+		return false;
+	store(photo);
+	return true;
+}
+
+void ingest_t::store(const photo_t& photo)
+{
+	metrics_t::timer_t timer(metrics(), metrics_t::insert);
+
+	// A link to a known photo shares its preview.
+	int64_t thumbnail = photo.thumbnail;
+	int64_t thumbnail_size = photo.thumbnail_size;
+	if(thumbnails && !photo.preview.empty())
+	{
+		thumbnail = thumbnails->append(photo.preview);
+		thumbnail_size = photo.preview.size();
+	}
+
+	insert_photo.execute(photo.file_name, photo.path, photo.size, photo.mtime.str(), photo.timestamp.str(), photo.checksum, photo.pixel_size.str(), photo.exif_size.str(), rebuilt, photo.dev, photo.ino, photo.hash, thumbnail, thumbnail_size);
+
+	// Shared by every row with the same tree checksum.
+	for(size_t i = 0; i < photo.chunks.size(); ++i)
+	{
+		uint64_t offset = i * options.chunk;
+		insert_chunk.execute(photo.hash, photo.checksum, i, offset, std::min<uint64_t>(options.chunk, photo.size - offset), photo.chunks[i]);
+	}
+
+	events.add(photo.timestamp.str());
+}
+
+ingest_t::status ingest_t::match(photo_t& photo)
+{
+	if(lookup(photo))
+	{
+		touch(photo);
+		return old;
+	}
+
+	if(relink(photo))
+		return moved;
+
+	return added;
+}
+
+ingest_t::status ingest_t::add(photo_t& photo)
+{
+	auto res = match(photo);
+	if(res == added)
+		insert(photo);
+	return res;
+}
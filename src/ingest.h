@@ -0,0 +1,76 @@
+/*
+ * ingest.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef INGEST_H_
+#define INGEST_H_
+#include <memory>
+#include <string>
+#include "db.h"
+#include "events.h"
+#include "photo.h"
+#include "reader.h"
+#include "thumbs.h"
+#include "timestamp.h"
+
+bool stat(photo_t& photo);
+// Sets up Exiv2's XMP parser, with a lock for it to take, so that exif()
+// can run on several threads. Called once before any exif().
+void exif_initialize();
+// With preview, also keeps the smallest embedded JPEG preview.
+void exif(photo_t& photo, bool preview = false);
+// False, with the checksum left empty, if the file could not be hashed.
+bool checksum(photo_t& photo, const read_options& options);
+
+/*
+ * Matches photos against the db and adds the ones not seen before.
+ */
+class ingest_t
+{
+private:
+	std::string rebuilt;
+	read_options options;
+	std::unique_ptr<thumbnails_t> thumbnails;
+
+	db_t::statement_t<std::string, std::string, uint64_t, std::string, std::string, std::string, std::string, std::string, std::string, uint64_t, uint64_t, std::string, int64_t, int64_t> insert_photo;
+	db_t::statement_t<std::string, std::string, uint64_t, std::string> photo_exists;
+	db_t::statement_t<uint64_t, uint64_t, uint64_t, std::string> inode_exists;
+	db_t::statement_t<std::string, uint64_t, uint64_t, int64_t> update_timestamp;
+	db_t::statement_t<std::string, std::string, std::string, int64_t> update_path;
+	db_t::statement_t<std::string, std::string, uint64_t, uint64_t, uint64_t, std::string> insert_chunk;
+	events_t events;
+public:
+	enum status
+	{
+		old,
+		moved,
+		added
+	};
+
+	ingest_t(db_t& db, const timestamp_t& rebuilt, const read_options& options = read_options());
+
+	// Fills in the stored details of a known photo; false if it is new.
+	bool lookup(photo_t& photo);
+	// Records that a known photo is still present.
+	void touch(const photo_t& photo);
+	// Finds a known photo under another name by its inode, size and mtime
+	// and moves (or for a hard link, copies) its row to this name.
+	bool relink(photo_t& photo);
+	// Reads the exif and checksum of a new photo; false if it could not be
+	// hashed, in which case it must not be stored.
+	bool read(photo_t& photo);
+	// Reads a new photo and adds it, unless it could not be hashed.
+	bool insert(photo_t& photo);
+	// Writes a photo whose details are already filled in.
+	void store(const photo_t& photo);
+
+	// Matches a photo by name, then by inode; added means it is new and
+	// still needs insert(). After add(), a new photo left with an empty
+	// checksum could not be hashed and was not stored.
+	status match(photo_t& photo);
+	status add(photo_t& photo);
+};
+
+#endif /* INGEST_H_ */
@@ -0,0 +1,196 @@
+/*
+ * metrics.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+const char* const names[] = {"walk", "stat", "lookup", "exif", "hash", "insert"};
+
+uint64_t clock_ns(clockid_t id)
+{
+	timespec ts;
+	clock_gettime(id, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+std::string duration(uint64_t ns)
+{
+	std::ostringstream s;
+	s << std::fixed << std::setprecision(1);
+	if(ns < 10000)
+		s << ns << "ns";
+	else if(ns < 10000000)
+		s << ns / 1e3 << "us";
+	else
+		s << ns / 1e6 << "ms";
+	return s.str();
+}
+
+}
+
+metrics_t::timer_t::timer_t(metrics_t& metrics, phase_t phase)
+ : metrics(metrics), phase(phase), wall(wall_now()), cpu(cpu_now()), bytes()
+{
+}
+
+void metrics_t::timer_t::add_bytes(uint64_t n)
+{
+	bytes += n;
+}
+
+metrics_t::timer_t::~timer_t()
+{
+	metrics.record(phase, wall, wall_now() - wall, cpu_now() - cpu, bytes);
+}
+
+metrics_t::metrics_t()
+{
+	reset();
+}
+
+uint64_t metrics_t::wall_now()
+{
+	return clock_ns(CLOCK_MONOTONIC);
+}
+
+uint64_t metrics_t::cpu_now()
+{
+	return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+int metrics_t::bucket(uint64_t ns)
+{
+	if(ns < 4)
+		return ns;
+	int msb = 63 - __builtin_clzll(ns);
+	return msb * 4 + ((ns >> (msb - 2)) & 3);
+}
+
+uint64_t metrics_t::bucket_value(int b)
+{
+	if(b < 4)
+		return b;
+	int msb = b / 4;
+	// Middle of the bucket.
+	return ((4ULL | (b & 3)) << (msb - 2)) + (1ULL << (msb - 2)) / 2;
+}
+
+uint64_t metrics_t::percentile(const phase_stats& p, double q)
+{
+	if(!p.count)
+		return 0;
+
+	uint64_t rank = std::max<uint64_t>(1, q * p.count + 0.5);
+	uint64_t seen(0);
+	for(int b = 0; b < buckets; ++b)
+	{
+		seen += p.histogram[b];
+		if(seen >= rank)
+			return bucket_value(b);
+	}
+	return bucket_value(buckets - 1);
+}
+
+void metrics_t::record(phase_t phase, uint64_t start, uint64_t wall_ns, uint64_t cpu_ns, uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(m);
+	auto& p = phases[phase];
+	if(!p.count || start < p.first)
+		p.first = start;
+	p.last = std::max(p.last, start + wall_ns);
+	++p.count;
+	p.wall_ns += wall_ns;
+	p.cpu_ns += cpu_ns;
+	p.bytes += bytes;
+	++p.histogram[bucket(wall_ns)];
+}
+
+void metrics_t::reset()
+{
+	std::lock_guard<std::mutex> lock(m);
+	memset(phases, 0, sizeof(phases));
+}
+
+void metrics_t::report(std::ostream& os) const
+{
+	std::lock_guard<std::mutex> lock(m);
+
+	// Formatted apart so that os (usually std::cerr) keeps its own flags.
+	std::ostringstream out;
+	out << std::left << std::setw(8) << "phase" << std::right
+	    << std::setw(10) << "items"
+	    << std::setw(10) << "wall(s)"
+	    << std::setw(10) << "cpu(s)"
+	    << std::setw(10) << "MB"
+	    << std::setw(12) << "items/s"
+	    << std::setw(10) << "p50"
+	    << std::setw(10) << "p95"
+	    << std::setw(10) << "p99" << "\n";
+
+	for(int i = 0; i < phase_count; ++i)
+	{
+		auto& p = phases[i];
+		if(!p.count)
+			continue;
+
+		double span = (p.last - p.first) / 1e9;
+		out << std::left << std::setw(8) << names[i] << std::right << std::fixed << std::setprecision(2)
+		    << std::setw(10) << p.count
+		    << std::setw(10) << p.wall_ns / 1e9
+		    << std::setw(10) << p.cpu_ns / 1e9
+		    << std::setw(10) << p.bytes / 1048576.0
+		    << std::setw(12) << p.count / std::max(span, 1e-9)
+		    << std::setw(10) << duration(percentile(p, 0.50))
+		    << std::setw(10) << duration(percentile(p, 0.95))
+		    << std::setw(10) << duration(percentile(p, 0.99)) << "\n";
+	}
+	os << out.str();
+}
+
+void metrics_t::write_json(std::ostream& os) const
+{
+	std::lock_guard<std::mutex> lock(m);
+
+	os << "{\n";
+	os << "   \"phases\":[";
+	bool first(true);
+	for(int i = 0; i < phase_count; ++i)
+	{
+		auto& p = phases[i];
+		double span = (p.last - p.first) / 1e9;
+
+		os << (first ? "\n" : ",\n");
+		first = false;
+		os << "      {";
+		os << "\"name\":\"" << names[i] << "\", ";
+		os << "\"count\":" << p.count << ", ";
+		os << "\"wall_ns\":" << p.wall_ns << ", ";
+		os << "\"cpu_ns\":" << p.cpu_ns << ", ";
+		os << "\"span_ns\":" << (p.last - p.first) << ", ";
+		os << "\"bytes\":" << p.bytes << ", ";
+		os << "\"per_sec\":" << (p.count ? p.count / std::max(span, 1e-9) : 0) << ", ";
+		os << "\"p50_ns\":" << percentile(p, 0.50) << ", ";
+		os << "\"p95_ns\":" << percentile(p, 0.95) << ", ";
+		os << "\"p99_ns\":" << percentile(p, 0.99);
+		os << "}";
+	}
+	os << "\n   ]\n";
+	os << "}\n";
+}
+
+metrics_t& metrics()
+{
+	static metrics_t instance;
+	return instance;
+}
@@ -0,0 +1,86 @@
+/*
+ * metrics.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+/*
+ * Per phase timings for a scan: wall and cpu time, bytes, rate and a
+ * per item latency histogram. Safe to record from any thread.
+ */
+class metrics_t
+{
+public:
+	enum phase_t
+	{
+		walk,	// listing one directory
+		stat,
+		lookup,
+		exif,
+		hash,
+		insert,
+		phase_count
+	};
+
+	// Times one item of a phase on the current thread.
+	class timer_t
+	{
+	private:
+		metrics_t& metrics;
+		phase_t phase;
+		uint64_t wall;
+		uint64_t cpu;
+		uint64_t bytes;
+	public:
+		timer_t(metrics_t& metrics, phase_t phase);
+		timer_t(const timer_t&) = delete;
+		timer_t& operator=(const timer_t&) = delete;
+
+		void add_bytes(uint64_t n);
+		~timer_t();
+	};
+
+	metrics_t();
+
+	void record(phase_t phase, uint64_t start, uint64_t wall_ns, uint64_t cpu_ns, uint64_t bytes);
+	void reset();
+
+	void report(std::ostream& os) const;
+	void write_json(std::ostream& os) const;
+
+	// nanoseconds on the monotonic and current thread's cpu clocks.
+	static uint64_t wall_now();
+	static uint64_t cpu_now();
+private:
+	// Four buckets per power of two.
+	static const int buckets = 64 * 4;
+
+	struct phase_stats
+	{
+		uint64_t count;
+		uint64_t wall_ns;
+		uint64_t cpu_ns;
+		uint64_t bytes;
+		uint64_t first;
+		uint64_t last;
+		uint64_t histogram[buckets];
+	};
+
+	mutable std::mutex m;
+	phase_stats phases[phase_count];
+
+	static int bucket(uint64_t ns);
+	static uint64_t bucket_value(int b);
+	static uint64_t percentile(const phase_stats& p, double q);
+};
+
+// The process wide metrics.
+metrics_t& metrics();
+
+#endif /* METRICS_H_ */
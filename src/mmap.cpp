@@ -11,11 +11,14 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include "util.h"
+#include <csetjmp>
+#include <csignal>
 #include <cstring>
+#include <mutex>
 #include <unistd.h>
 
-fd_t::fd_t(const char* name, int flags)
- : fd(open(name, flags))
+fd_t::fd_t(const char* name, int flags, mode_t mode)
+ : fd(open(name, flags, mode))
 {
 	throw_if(fd == -1, strerror(errno));
 }
@@ -30,11 +33,48 @@ fd_t::~fd_t()
 	close(fd);
 }
 
-mmap_t::mmap_t(const char* filename, std::size_t size)
- : fd(filename, O_RDONLY), addr(nullptr), size(size)
+mmap_t::mmap_t(const char* filename, int hints)
+ : fd(filename, O_RDONLY), addr(nullptr), size(), hints(hints)
 {
-	addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	struct stat sb;
+	throw_if(fstat(fd, &sb) != 0, strerror(errno));
+	throw_if(!S_ISREG(sb.st_mode), "not a regular file");
+
+	size = sb.st_size;
+	if(!size)
+		return;
+
+	addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | ((hints & populate) ? MAP_POPULATE : 0), fd, 0);
 	throw_if(addr == MAP_FAILED, strerror(errno));
+
+	// Advice is only advice; failures are not errors.
+	if(hints & sequential)
+		madvise(addr, size, MADV_SEQUENTIAL);
+	if(hints & willneed)
+		madvise(addr, size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+	if(hints & hugepage)
+		madvise(addr, size, MADV_HUGEPAGE);
+#endif
+}
+
+std::size_t mmap_t::length() const
+{
+	return size;
+}
+
+void mmap_t::release(std::size_t offset, std::size_t length)
+{
+	if(!(hints & dontneed) || !addr)
+		return;
+
+	// madvise needs a page aligned start.
+	static const std::size_t page = sysconf(_SC_PAGESIZE);
+	std::size_t start = offset & ~(page - 1);
+	length += offset - start;
+
+	madvise(static_cast<char*>(addr) + start, length, MADV_DONTNEED);
+	posix_fadvise(fd, start, length, POSIX_FADV_DONTNEED);
 }
 
 mmap_t::operator void*() const
@@ -44,6 +84,88 @@ mmap_t::operator void*() const
 
 mmap_t::~mmap_t()
 {
-	munmap(addr, size);
+	if(addr)
+		munmap(addr, size);
 }
 
+namespace
+{
+
+// volatile, or the compiler may drop the store around a memcpy() it knows
+// does not read it.
+thread_local sigjmp_buf* volatile sigbus_env = nullptr;
+
+void on_sigbus(int sig, siginfo_t*, void*)
+{
+	if(sigbus_env)
+		siglongjmp(*sigbus_env, 1);
+
+	// Not ours; die as we would have.
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+}
+
+void copy_mapped(void* dst, const void* src, std::size_t length)
+{
+	static std::once_flag installed;
+	std::call_once(installed, []
+	{
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = on_sigbus;
+		sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+		sigaction(SIGBUS, &sa, nullptr);
+	});
+
+	sigjmp_buf env;
+	sigjmp_buf* prev = sigbus_env;
+	if(sigsetjmp(env, 1))
+	{
+		sigbus_env = prev;
+		throw std::runtime_error("file truncated while reading");
+	}
+
+	sigbus_env = &env;
+	memcpy(dst, src, length);
+	sigbus_env = prev;
+}
+
+int parse_mmap_hints(const char* s)
+{
+	static const struct
+	{
+		const char* name;
+		int hint;
+	} names[] = {
+		{"populate", mmap_t::populate},
+		{"sequential", mmap_t::sequential},
+		{"willneed", mmap_t::willneed},
+		{"hugepage", mmap_t::hugepage},
+		{"dontneed", mmap_t::dontneed},
+		{"none", 0}
+	};
+
+	int hints(0);
+	while(*s)
+	{
+		std::size_t len = strcspn(s, ",");
+		bool found(false);
+		for(auto& n : names)
+		{
+			if(strlen(n.name) == len && strncmp(s, n.name, len) == 0)
+			{
+				hints |= n.hint;
+				found = true;
+			}
+		}
+		if(!found)
+			return -1;
+
+		s += len;
+		if(*s == ',')
+			++s;
+	}
+	return hints;
+}
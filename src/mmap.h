@@ -8,13 +8,15 @@
 #ifndef MMAP_H_
 #define MMAP_H_
 #include <cstddef>
+#include <sys/types.h>
 
 class fd_t
 {
 private:
 	int fd;
 public:
-	fd_t(const char* name, int flags);
+	// mode applies only with O_CREAT.
+	fd_t(const char* name, int flags, mode_t mode = 0644);
 	operator int() const;
 	~fd_t();
 };
@@ -24,10 +26,39 @@ private:
 	fd_t fd;
 	void* addr;
 	std::size_t size;
+	int hints;
 public:
-	mmap_t(const char* filename, std::size_t size);
+	enum hint
+	{
+		populate = 1 << 0,		// MAP_POPULATE; fault the whole file in up front
+		sequential = 1 << 1,	// MADV_SEQUENTIAL
+		willneed = 1 << 2,		// MADV_WILLNEED
+		hugepage = 1 << 3,		// MADV_HUGEPAGE, where the kernel supports it for files
+		dontneed = 1 << 4		// release() drops consumed pages from the page cache
+	};
+
+	// Maps the file as it is now (by fstat() on the open file), which may
+	// differ from an earlier stat(). An empty file maps to nullptr.
+	mmap_t(const char* filename, int hints = 0);
+
+	std::size_t length() const;
+
+	// Done with [offset, offset + length); only acts with dontneed.
+	void release(std::size_t offset, std::size_t length);
+
 	operator void*() const;
 	~mmap_t();
 };
 
+/*
+ * memcpy() from a mapping, turning the SIGBUS raised by touching a page
+ * beyond the end of a file truncated since it was mapped into
+ * std::runtime_error. Nothing but the copy runs while the fault can jump
+ * back, so no destructor is skipped.
+ */
+void copy_mapped(void* dst, const void* src, std::size_t length);
+
+// Parses a comma separated list of hint names; -1 if one is unknown.
+int parse_mmap_hints(const char* s);
+
 #endif /* MMAP_H_ */
@@ -0,0 +1,223 @@
+/*
+ * output.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "output.h"
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+
+const char hex_digits[] = "0123456789abcdef";
+
+// For each byte: 0 if it stands as is in a JSON string, else the letter
+// after the backslash, with u for a \u00XX escape, or 8 where a multibyte
+// UTF-8 sequence has to be checked.
+struct json_escapes_t
+{
+	char escape[256];
+
+	json_escapes_t()
+	{
+		memset(escape, 0, sizeof(escape));
+		for(int c = 0; c < 0x20; ++c)
+			escape[c] = 'u';
+		for(int c = 0x80; c < 0x100; ++c)
+			escape[c] = 8;
+		escape['"'] = '"';
+		escape['\\'] = '\\';
+		escape['\b'] = 'b';
+		escape['\f'] = 'f';
+		escape['\n'] = 'n';
+		escape['\r'] = 'r';
+		escape['\t'] = 't';
+	}
+} const json_escapes;
+
+// Length of the well formed UTF-8 sequence at p (RFC 3629: no overlong
+// forms, surrogates or code points past U+10FFFF), or 0.
+std::size_t utf8_length(const unsigned char* p, const unsigned char* end)
+{
+	unsigned char lo(0x80);
+	unsigned char hi(0xbf);
+	std::size_t n;
+	if(*p >= 0xc2 && *p <= 0xdf)
+		n = 2;
+	else if(*p >= 0xe0 && *p <= 0xef)
+	{
+		n = 3;
+		if(*p == 0xe0)
+			lo = 0xa0;
+		else if(*p == 0xed)
+			hi = 0x9f;
+	}
+	else if(*p >= 0xf0 && *p <= 0xf4)
+	{
+		n = 4;
+		if(*p == 0xf0)
+			lo = 0x90;
+		else if(*p == 0xf4)
+			hi = 0x8f;
+	}
+	else
+		return 0;
+
+	if(static_cast<std::size_t>(end - p) < n || p[1] < lo || p[1] > hi)
+		return 0;
+	for(std::size_t i = 2; i < n; ++i)
+		if((p[i] & 0xc0) != 0x80)
+			return 0;
+	return n;
+}
+
+// Calls put(data, length) with the escaped body of a JSON string.
+template <typename Put>
+void escape_json(const char* s, std::size_t n, Put put)
+{
+	const char* run = s;
+	for(const char* p = s; p != s + n; ++p)
+	{
+		unsigned char c = *p;
+		char e = json_escapes.escape[c];
+		if(!e)
+			continue;
+
+		if(e == 8)
+		{
+			// Valid sequences stand as they are.
+			std::size_t length = utf8_length(reinterpret_cast<const unsigned char*>(p), reinterpret_cast<const unsigned char*>(s + n));
+			if(length)
+			{
+				p += length - 1;
+				continue;
+			}
+		}
+
+		put(run, p - run);
+		if(e == 8)
+		{
+			static const char replacement[] = "\\ufffd";
+			put(replacement, sizeof(replacement) - 1);
+		}
+		else if(e == 'u')
+		{
+			const char u[] = {'\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf]};
+			put(u, sizeof(u));
+		}
+		else
+		{
+			const char esc[] = {'\\', e};
+			put(esc, sizeof(esc));
+		}
+		run = p + 1;
+	}
+	put(run, s + n - run);
+}
+
+}
+
+writer_t::writer_t(FILE* f, std::size_t size)
+ : f(f), buffer(size), used(0), error(0)
+{
+}
+
+writer_t& writer_t::put(const char* s, std::size_t n)
+{
+	if(used + n > buffer.size())
+	{
+		flush();
+		if(n > buffer.size())
+		{
+			if(fwrite(s, 1, n, f) != n && !error)
+				error = errno;
+			return *this;
+		}
+	}
+	memcpy(buffer.data() + used, s, n);
+	used += n;
+	return *this;
+}
+
+writer_t& writer_t::put(int64_t n)
+{
+	char digits[24];
+	char* end = digits + sizeof(digits);
+	char* p = end;
+
+	uint64_t u = n < 0 ? -static_cast<uint64_t>(n) : n;
+	do
+	{
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while(u);
+	if(n < 0)
+		*--p = '-';
+
+	return put(p, end - p);
+}
+
+writer_t& writer_t::json(const char* s, std::size_t n)
+{
+	put('"');
+	escape_json(s, n, [this](const char* data, std::size_t length)
+	{
+		put(data, length);
+	});
+	return put('"');
+}
+
+writer_t& writer_t::csv(const char* s, std::size_t n)
+{
+	bool quote(false);
+	for(const char* p = s; p != s + n && !quote; ++p)
+		quote = *p == ',' || *p == '"' || *p == '\n' || *p == '\r';
+	if(!quote)
+		return put(s, n);
+
+	// Quotes inside are doubled.
+	put('"');
+	const char* run = s;
+	for(const char* p = s; p != s + n; ++p)
+	{
+		if(*p == '"')
+		{
+			put(run, p - run + 1);
+			run = p;
+		}
+	}
+	put(run, s + n - run);
+	return put('"');
+}
+
+void writer_t::flush()
+{
+	if(used && fwrite(buffer.data(), 1, used, f) != used && !error)
+		error = errno;
+	used = 0;
+}
+
+int writer_t::finish()
+{
+	flush();
+	if((fflush(f) != 0 || ferror(f)) && !error)
+		error = errno ? errno : EIO;
+	return error;
+}
+
+writer_t::~writer_t()
+{
+	finish();
+}
+
+std::string json_quote(const std::string& s)
+{
+	std::string quoted(1, '"');
+	escape_json(s.data(), s.size(), [&quoted](const char* data, std::size_t length)
+	{
+		quoted.append(data, length);
+	});
+	return quoted + '"';
+}
@@ -0,0 +1,64 @@
+/*
+ * output.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Buffers output and hands it to the FILE in large writes, with none of the
+ * per-call cost of an ostream. Listing a million rows is then bound by the
+ * db rather than by formatting.
+ */
+class writer_t
+{
+private:
+	FILE* f;
+	std::vector<char> buffer;
+	std::size_t used;
+	int error;	// errno of the first write that failed
+public:
+	explicit writer_t(FILE* f, std::size_t size = 64 << 10);
+
+	writer_t(const writer_t&) = delete;
+	writer_t& operator=(const writer_t&) = delete;
+
+	writer_t& put(char c)
+	{
+		if(used == buffer.size())
+			flush();
+		buffer[used++] = c;
+		return *this;
+	}
+	writer_t& put(const char* s, std::size_t n);
+	writer_t& put(const std::string& s)
+	{
+		return put(s.data(), s.size());
+	}
+	writer_t& put(int64_t n);
+
+	// s as a quoted JSON string. Bytes that are not UTF-8 become U+FFFD.
+	writer_t& json(const char* s, std::size_t n);
+	// s as a CSV field, quoted only if it has to be.
+	writer_t& csv(const char* s, std::size_t n);
+
+	void flush();
+
+	// Flushes the FILE as well; the errno of the first write that failed,
+	// or 0.
+	int finish();
+
+	~writer_t();
+};
+
+// s as a quoted JSON string, as writer_t::json() writes it.
+std::string json_quote(const std::string& s);
+
+#endif /* OUTPUT_H_ */
@@ -6,6 +6,7 @@
  */
 
 #include "photo.h"
+#include "output.h"
 #include <sstream>
 #include <tuple>
 
@@ -45,7 +46,7 @@ bool dim::operator==(const dim& o) const
 }
 
 photo_t::photo_t(const std::string& name, const std::string& path)
- : id(0), file_name(name), path(path), size(0)
+ : id(0), file_name(name), path(path), size(0), dev(0), ino(0), thumbnail(0), thumbnail_size(0)
 {
 }
 
@@ -57,12 +58,13 @@ std::string photo_t::full_filename() const
 std::ostream& operator<<(std::ostream& os, const photo_t& photo)
 {
 	os << "{\n";
-	os << "   \"file_name\":\"" << photo.file_name << "\",\n";
-	os << "   \"path\":\"" << photo.path << "\",\n";
+	os << "   \"file_name\":" << json_quote(photo.file_name) << ",\n";
+	os << "   \"path\":" << json_quote(photo.path) << ",\n";
 	os << "   \"size\":\"" << photo.size << "\",\n";
 	os << "   \"mtime\":\"" << photo.mtime << "\",\n";
 	os << "   \"timestamp\":\"" << photo.timestamp << "\",\n";
-	os << "   \"checksum\":\"" << photo.checksum << "\",\n";
+	os << "   \"checksum\":" << json_quote(photo.checksum) << ",\n";
+	os << "   \"hash\":" << json_quote(photo.hash) << ",\n";
 	os << "   \"pixel_size\":\"" << photo.pixel_size.width << "," << photo.pixel_size.height << "\",\n";
 	os << "   \"exif_size\":\"" << photo.exif_size.width << "," << photo.exif_size.height << "\"\n";
 	os << "}";
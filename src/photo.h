@@ -8,6 +8,7 @@
 #ifndef PHOTO_H_
 #define PHOTO_H_
 #include <string>
+#include <vector>
 #include <ostream>
 #include "timestamp.h"
 
@@ -35,12 +36,21 @@ struct photo_t
 	uint64_t size;
 	timestamp_t mtime;
 
+	uint64_t dev;
+	uint64_t ino;
+
 	timestamp_t timestamp;
 	std::string checksum;
+	std::string hash;	// algorithm the checksum was taken with
+	std::vector<std::string> chunks;	// digests of each chunk, for a tree hash
 
 	dim pixel_size;
 	dim exif_size;
 
+	std::string preview;	// embedded JPEG preview, until stored
+	int64_t thumbnail;		// where the stored preview is; see thumbnails_t
+	int64_t thumbnail_size;	// 0 for none
+
 	photo_t(const std::string& name, const std::string& path);
 
 	std::string full_filename() const;
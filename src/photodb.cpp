@@ -4,199 +4,32 @@
  *  Created on: 24/03/2013
  *      Author: nicholas
  */
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
-#include <dirent.h>
-#include <memory>
+#include <tuple>
 #include <vector>
 
-#include <exiv2/exiv2.hpp>
-
-#include <sys/stat.h>
-#include "sha1.h"
 #include "db.h"
-#include "photo.h"
-#include "timestamp.h"
+#include "events.h"
+#include "export.h"
+#include "ingest.h"
 #include "mmap.h"
+#include "query.h"
+#include "scan.h"
+#include "search.h"
+#include "serve.h"
+#include "shards.h"
+#include "schema.h"
+#include "snapshot.h"
+#include "thumbs.h"
 #include "util.h"
+#include "verify.h"
+#include "watch.h"
 
 #include <unistd.h>
 
-template <typename Fn>
-bool enumerate_directory(const std::string& path, Fn func)
-{
-	auto delete_dir = [](DIR* d){ closedir(d); };
-	std::unique_ptr<DIR, decltype(delete_dir)> dir(opendir(path.c_str()), delete_dir);
-	if (!dir)
-	{
-		std::cerr << "Unable to open directory '" << path << "'\n";
-		return false;
-	}
-
-	dirent entry;
-	dirent *result;
-	for (int res = readdir_r(dir.get(), &entry, &result); result != nullptr && res == 0; res = readdir_r(dir.get(), &entry, &result))
-	{
-		std::string name = entry.d_name;
-		if(entry.d_type == DT_DIR)
-		{
-			if(name != "." && name != "..")
-				if(!enumerate_directory(path + '/' + name, func))
-					return false;
-		}
-		else if(entry.d_type == DT_REG)
-		{
-			func({name, path});
-		}
-	}
-
-	return true;
-}
-
-void exif(photo_t& photo)
-{
-	try
-	{
-		auto image = Exiv2::ImageFactory::open(photo.full_filename());
-
-		if (image.get())
-		{
-			image->readMetadata();
-			photo.pixel_size = {image->pixelWidth(), image->pixelHeight()};
-
-			Exiv2::ExifData &exifData = image->exifData();
-			if (!exifData.empty())
-			{
-				{
-					auto x = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelXDimension"));
-					if(x == exifData.end())
-						x = exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageWidth"));
-
-					auto y = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelYDimension"));
-					if(y == exifData.end())
-						y = exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageLength"));
-
-					if(x != exifData.end() && y != exifData.end())
-					{
-						photo.exif_size = {x->value().toLong(), y->value().toLong()};
-					}
-				}
-
-				auto datetime = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
-				if(datetime == exifData.end())
-					datetime = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTime"));
-				if(datetime == exifData.end())
-					datetime = exifData.findKey(Exiv2::ExifKey("Exif.Image.DateTime"));
-
-				if(datetime != exifData.end())
-				{
-					std::string timestamp = datetime->value().toString();
-					for(auto x = begin(timestamp); x != end(timestamp); )
-						if(*x == ' ')
-							x = timestamp.erase(x);
-						else
-							++x;
-					photo.timestamp = timestamp_t{timestamp};
-				}
-			}
-		}
-	}
-	catch(const Exiv2::BasicError<char>& ex)
-	{
-		std::cerr << ex << "\n";
-	}
-
-}
-
-bool checksum(photo_t& photo)
-{
-	try
-	{
-		mmap_t addr(photo.full_filename().c_str(), photo.size);
-
-		unsigned char hash[20];
-		sha1::calc(addr, photo.size, hash);
-
-		char hexstring[41];
-		sha1::toHexString(hash, hexstring);
-		photo.checksum = hexstring;
-
-		return true;
-	}
-	catch(const std::runtime_error& ex)
-	{
-		return false;
-	}
-}
-
-bool rebuild_db(db_t& db, const std::string& src)
-{
-	timestamp_t rebuilt(time(nullptr));
-	
-	db_t::statement_t<std::string, std::string, uint64_t, std::string, std::string, std::string, std::string, std::string, std::string> insert_photo{db, "INSERT INTO photos VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"};
-	db_t::statement_t<std::string, std::string, uint64_t, std::string> photo_exists{db, "SELECT ROWID, timestamp, checksum, pixel_size, exif_size FROM photos WHERE file_name = ? AND path = ? AND size = ? and mtime = ?"};
-	db_t::statement_t<std::string, int64_t> update_timestamp{db, "UPDATE photos set rebuilt = ? WHERE ROWID = ?"};
-
-	std::vector<std::shared_ptr<photo_t> > photo_list;
-	if(!enumerate_directory(src, [&photo_list](photo_t photo)
-	{
-		struct stat sb;
-		if(stat(photo.full_filename().c_str(), &sb) != 0)
-		{
-			std::cerr << photo.full_filename() << ": Unable to stat()\n";
-			return;
-		}
-
-		photo.size = sb.st_size;
-		photo.mtime = timestamp_t{sb.st_mtime};
-		photo_list.emplace_back(new photo_t(photo));
-	}))
-		return false;
-
-	std::cerr << photo_list.size() << " Files.\n";
-
-	// update db.
-	db.execute("PRAGMA synchronous = OFF");
-
-	size_t stat_new(0);
-	size_t stat_old(0);
-	for(auto& photo : photo_list)
-	{
-		bool new_photo(true);
-		auto x = [&photo, &new_photo](const std::tuple<int64_t, std::string, std::string, std::string, std::string>& t)
-		{
-			photo->id = std::get<0>(t);
-			photo->timestamp = timestamp_t{std::get<1>(t)};
-			photo->checksum = std::get<2>(t);
-			photo->pixel_size = {std::get<3>(t)};
-			photo->exif_size = {std::get<4>(t)};
-			new_photo = false;
-		};
-		photo_exists.query<decltype(x), int64_t, std::string, std::string, std::string, std::string>(x, photo->file_name, photo->path, photo->size, photo->mtime.str());
-
-		if(new_photo)
-		{
-			exif(*photo);
-			checksum(*photo);
-
-			insert_photo.execute(photo->file_name, photo->path, photo->size, photo->mtime.str(), photo->timestamp.str(), photo->checksum, photo->pixel_size.str(), photo->exif_size.str(), rebuilt.str());
-		}
-		else
-		{
-			update_timestamp.execute(rebuilt.str(), photo->id);
-		}
-
-		++(new_photo ? stat_new : stat_old);
-		
-		if(stat_new && stat_new % 100 == 0)
-		{
-			std::cout << "new: " << stat_new << "; old: " << stat_old << "\n";
-		}
-	}
-	std::cout << "new: " << stat_new << "; old: " << stat_old << "\n";
-	return true;
-}
-
 std::vector<std::string> identify_checksum_dups(db_t& db)
 {
 	std::vector<std::tuple<std::string, std::string> > dups;
@@ -246,31 +79,246 @@ int main(int argc, char* argv[])
 {
 	std::vector<std::string> args(argv, argv+argc);
 	assert(!args.empty());
+	exif_initialize();
 
-	if(args.size() < 2)
+	auto usage = [&args]
 	{
-		std::cerr << args[0] << " src_folder\n";
+		std::cerr << args[0] << " [--full] [--resume] [--order=physical|directory] [--readahead=MB] [--memory=MB] [--io=map|stream|direct|uring] [--mmap=hint,...] [--threads=N] [--depth=N] [--hash=sha1|xxh3-128|blake3] [--tree=MB] [--chunk=MB] [--thumbnails] [--metrics=file.json] src_folder...\n";
+		std::cerr << args[0] << " watch [--debounce=ms] [scan options] src_folder\n";
+		std::cerr << args[0] << " verify [--rate=MB] [--iops=N] [--limit=N] [--idle] [--continuous] src_folder\n";
+		std::cerr << args[0] << " export [--format=ndjson|json|csv] [query options] src_folder...\n";
+		std::cerr << args[0] << " dups src_folder...\n";
+		std::cerr << args[0] << " search [--limit=N] words... src_folder\n";
+		std::cerr << args[0] << " serve [--socket=path] [--threads=N] src_folder\n";
+		std::cerr << args[0] << " events [--gap=minutes] [--list] src_folder\n";
+		std::cerr << args[0] << " snapshot src_folder\n";
+		std::cerr << args[0] << " stats src_folder\n";
+		std::cerr << args[0] << " thumbnail --id=N src_folder\n";
+		std::cerr << args[0] << " query [--from=date] [--to=date] [--month=yyyy-mm] [--path=dir] [--min-size=N[KMG]] [--max-size=N[KMG]] [--pixel-size=WxH] [--exif-size=WxH] [--min-width=N] [--min-height=N] [--event=N] [--count] src_folder...\n";
 		return 1;
+	};
+
+	auto option = [](const std::string& arg, const std::string& name, std::string& value)
+	{
+		if(arg.compare(0, name.size() + 1, name + '=') != 0)
+			return false;
+		value = arg.substr(name.size() + 1);
+		return true;
+	};
+
+	size_t i = 1;
+	std::string command;
+	if(i < args.size() && (args[i] == "watch" || args[i] == "verify" || args[i] == "query" || args[i] == "export" || args[i] == "events" || args[i] == "snapshot" || args[i] == "stats" || args[i] == "thumbnail" || args[i] == "dups" || args[i] == "serve" || args[i] == "search"))
+		command = args[i++];
+
+	scan_options options;
+	int debounce(2000);
+	verify_options verify;
+	export_options exporting;
+	query_options& query = exporting.query;
+	event_options events;
+	serve_options serving;
+	search_options search;
+	bool thumbnails(false);
+	int64_t id(0);
+
+	// A bad value in one is as much a usage error as any other.
+	bool bad_query(false);
+	auto query_option = [&query, &bad_query](const std::string& arg)
+	{
+		try
+		{
+			return parse_query_option(arg, query);
+		}
+		catch(const std::invalid_argument&)
+		{
+			bad_query = true;
+			return true;
+		}
+	};
+
+	std::vector<std::string> roots;
+	for(std::string value; i < args.size(); ++i)
+	{
+		if(args[i] == "--full")
+			options.full = true;
+		else if(args[i] == "--resume")
+			options.resume = true;
+		else if(option(args[i], "--order", value))
+		{
+			if(value == "physical")
+				options.order = scan_options::physical;
+			else if(value == "directory")
+				options.order = scan_options::directory;
+			else
+				return usage();
+		}
+		else if(option(args[i], "--readahead", value))
+		{
+			if(!parse_number(value, options.readahead))
+				return usage();
+			options.readahead <<= 20;
+		}
+		else if(option(args[i], "--memory", value))
+		{
+			if(!parse_number(value, options.memory))
+				return usage();
+			options.memory <<= 20;
+		}
+		else if(option(args[i], "--mmap", value))
+		{
+			options.read.map_hints = parse_mmap_hints(value.c_str());
+			if(options.read.map_hints == -1)
+				return usage();
+		}
+		else if(option(args[i], "--metrics", value))
+			options.metrics_file = value;
+		else if(option(args[i], "--threads", value))
+		{
+			if(!parse_number(value, command == "serve" ? serving.threads : options.read.threads))
+				return usage();
+		}
+		else if(option(args[i], "--depth", value))
+		{
+			if(!parse_number(value, options.read.depth))
+				return usage();
+			options.read.depth = std::max(options.read.depth, 1u);
+		}
+		else if(option(args[i], "--tree", value))
+		{
+			if(!parse_number(value, options.read.tree))
+				return usage();
+			options.read.tree <<= 20;
+		}
+		else if(option(args[i], "--chunk", value))
+		{
+			if(!parse_number(value, options.read.chunk))
+				return usage();
+			options.read.chunk = std::max<uint64_t>(options.read.chunk, 1) << 20;
+		}
+		else if(option(args[i], "--hash", value))
+		{
+			if(!parse_hash(value, options.read.hash))
+				return usage();
+		}
+		else if(option(args[i], "--io", value))
+		{
+			if(!parse_read_mode(value, options.read.mode))
+				return usage();
+		}
+		else if(args[i] == "--thumbnails")
+			thumbnails = true;
+		else if(option(args[i], "--id", value))
+		{
+			if(!parse_number(value, id))
+				return usage();
+		}
+		else if(option(args[i], "--debounce", value))
+		{
+			if(!parse_number(value, debounce) || debounce < 0)
+				return usage();
+		}
+		else if(option(args[i], "--rate", value))
+		{
+			if(!parse_number(value, verify.rate))
+				return usage();
+			verify.rate <<= 20;
+		}
+		else if(option(args[i], "--iops", value))
+		{
+			if(!parse_number(value, verify.iops))
+				return usage();
+		}
+		else if(option(args[i], "--limit", value))
+		{
+			if(!parse_number(value, command == "search" ? search.limit : verify.limit))
+				return usage();
+		}
+		else if(args[i] == "--idle")
+			verify.idle = true;
+		else if(args[i] == "--continuous")
+			verify.continuous = true;
+		else if(query_option(args[i]))
+			;
+		else if(option(args[i], "--socket", value))
+			serving.socket = value;
+		else if(option(args[i], "--gap", value))
+		{
+			if(!parse_number(value, events.gap) || events.gap < 0 || events.gap > INT64_MAX / 60)
+				return usage();
+			events.gap *= 60;
+		}
+		else if(args[i] == "--list")
+			events.list = true;
+		else if(option(args[i], "--format", value))
+		{
+			if(!parse_export_format(value, exporting.format))
+				return usage();
+		}
+		else if(args[i].compare(0, 2, "--") == 0)
+			return usage();
+		else
+		{
+			roots.push_back(args[i]);
+			if(roots.back().size() > 1 && roots.back().back() == '/')
+				roots.back().pop_back();
+		}
 	}
+	if(bad_query)
+		return usage();
 
-	auto src = args[1];
-	if(src.empty())
+	// The words to search for come before the folder.
+	if(command == "search")
 	{
-		std::cerr << args[0] << " src_folder\n";
-		return 1;
+		for(size_t j = 0; j + 1 < roots.size(); ++j)
+			search.match += (j ? " " : "") + roots[j];
+		roots.erase(roots.begin(), roots.end() - std::min<size_t>(roots.size(), 1));
+		if(search.match.empty())
+			return usage();
 	}
 
-	if(src.back() == '/')
-		src.pop_back();
+	if(roots.empty())
+		return usage();
 
-	db_t db{src + "/photo.db"};
-	db.execute("CREATE TABLE IF NOT EXISTS photos (file_name TEXT, path TEXT, size INTEGER, mtime TEXT, timestamp TEXT, checksum TEXT, pixel_size TEXT, exif_size TEXT, rebuilt TEXT)");
-	db.execute("CREATE INDEX IF NOT EXISTS photos_idx ON photos (file_name, path, size, mtime)");
+	// The scan, queries and exports span any number of roots; the rest
+	// work on one.
+	if(roots.size() > 1 && !command.empty() && command != "query" && command != "export" && command != "dups")
+		return usage();
+
+	options.thumbnails = thumbnails;
+	if(command.empty())
+		return rebuild_roots(roots, options) ? 0 : 1;
+	if(command == "dups")
+		return dups_db(roots) ? 0 : 1;
+
+	const std::string& src = roots[0];
+	if(command == "stats")
+		return stats_db(src) ? 0 : 1;
+	if(command == "serve")
+		return serve_db(src, serving) ? 0 : 1;
 
-	if(!rebuild_db(db, src))
+	db_t db{src + "/photo.db"};
+	create_schema(db);
+	if(roots.size() > 1 && !attach_shards(db, roots))
 		return 1;
 
-	
+	if(command == "watch")
+		return watch_db(db, src, debounce, options) ? 0 : 1;
+	if(command == "verify")
+		return verify_db(db, verify) ? 0 : 1;
+	if(command == "query")
+		return query_db(db, roots, query) ? 0 : 1;
+	if(command == "export")
+		return export_db(db, roots, exporting) ? 0 : 1;
+	if(command == "events")
+		return events_db(db, events) ? 0 : 1;
+	if(command == "snapshot")
+		return snapshot_db(db, src) ? 0 : 1;
+	if(command == "thumbnail")
+		return thumbnail_db(db, src, id) ? 0 : 1;
+	if(command == "search")
+		return search_db(db, search) ? 0 : 1;
+
 
 /*
 TODO list
@@ -0,0 +1,246 @@
+/*
+ * query.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "query.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "output.h"
+#include "util.h"
+
+bool parse_query_option(const std::string& arg, query_options& options)
+{
+	auto eq = arg.find('=');
+	if(arg.compare(0, 2, "--") != 0)
+		return false;
+	std::string name = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+	std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+
+	// 12M, 3G ...
+	auto size = [&arg](std::string value)
+	{
+		unsigned shift(0);
+		switch(value.empty() ? 0 : toupper(value.back()))
+		{
+			case 'G':
+				shift += 10;
+				// fall through
+			case 'M':
+				shift += 10;
+				// fall through
+			case 'K':
+				shift += 10;
+				value.pop_back();
+		}
+		uint64_t n(0);
+		throw_if<std::invalid_argument>(!parse_number(value, n) || n > UINT64_MAX >> shift, arg);
+		return n << shift;
+	};
+	// 4000x3000 as stored.
+	auto dimensions = [](std::string value)
+	{
+		std::replace(begin(value), end(value), 'x', ',');
+		return value;
+	};
+
+	if(eq == std::string::npos)
+	{
+		if(name != "count")
+			return false;
+		options.count = true;
+	}
+	else if(name == "from")
+		options.from = value;
+	else if(name == "to")
+		options.to = value;
+	else if(name == "month")
+		options.from = options.to = value;
+	else if(name == "path")
+		options.path = value;
+	else if(name == "min-size")
+		options.min_size = size(value);
+	else if(name == "max-size")
+		options.max_size = size(value);
+	else if(name == "pixel-size")
+		options.pixel_size = dimensions(value);
+	else if(name == "exif-size")
+		options.exif_size = dimensions(value);
+	else if(name == "min-width")
+		throw_if<std::invalid_argument>(!parse_number(value, options.min_width), arg);
+	else if(name == "min-height")
+		throw_if<std::invalid_argument>(!parse_number(value, options.min_height), arg);
+	else if(name == "event")
+		throw_if<std::invalid_argument>(!parse_number(value, options.event), arg);
+	else
+		return false;
+	return true;
+}
+
+std::string sql_quote(const std::string& s)
+{
+	std::unique_ptr<char, void(*)(void*)> q(sqlite3_mprintf("%Q", s.c_str()), sqlite3_free);
+	return q.get();
+}
+
+query_options::query_options()
+ : min_size(0), max_size(0), min_width(0), min_height(0), event(0), count(false)
+{
+}
+
+query_params_t& query_params_t::add(const std::string& s)
+{
+	params.push_back({true, s, 0});
+	return *this;
+}
+
+query_params_t& query_params_t::add(int64_t n)
+{
+	params.push_back({false, {}, n});
+	return *this;
+}
+
+void query_params_t::bind(db_t::statement_t<>& stmt) const
+{
+	for(std::size_t i = 0; i < params.size(); ++i)
+	{
+		if(params[i].text)
+			stmt.bind(i + 1, params[i].s);
+		else
+			stmt.bind(i + 1, params[i].n);
+	}
+}
+
+std::string query_where(const std::vector<std::string>& roots, const query_options& options, query_params_t& params)
+{
+	std::vector<std::string> terms;
+
+	// Timestamps are text, so a prefix bounds a range: '~' sorts after any
+	// character a timestamp holds, making the upper bound inclusive.
+	if(!options.from.empty())
+	{
+		terms.push_back("timestamp >= ?");
+		params.add(options.from);
+	}
+	if(!options.to.empty())
+	{
+		terms.push_back("timestamp < ?");
+		params.add(options.to + '~');
+
+		// Unknown times are stored as zeros, which are not before anything.
+		if(options.from.empty())
+			terms.push_back("timestamp >= '0001'");
+	}
+
+	// An event is a run of the timestamp index.
+	if(options.event)
+	{
+		terms.push_back("timestamp >= (SELECT start FROM events WHERE id = ?)");
+		terms.push_back("timestamp <= (SELECT end FROM events WHERE id = ?)");
+		params.add(options.event).add(options.event);
+	}
+
+	// A relative path is looked for under every root.
+	if(!options.path.empty())
+	{
+		std::string any;
+		for(std::size_t i = 0; i < (options.path[0] == '/' ? 1 : roots.size()); ++i)
+		{
+			std::string path = options.path[0] == '/' ? options.path : roots[i] + '/' + options.path;
+			while(path.size() > 1 && path.back() == '/')
+				path.pop_back();
+			any += (any.empty() ? "" : " OR ") + std::string("path = ? OR (path >= ? AND path < ?)");
+			params.add(path).add(path + '/').add(path + '0');
+		}
+		terms.push_back('(' + any + ')');
+	}
+
+	if(options.min_size)
+	{
+		terms.push_back("size >= ?");
+		params.add(static_cast<int64_t>(options.min_size));
+	}
+	if(options.max_size)
+	{
+		terms.push_back("size <= ?");
+		params.add(static_cast<int64_t>(options.max_size));
+	}
+
+	if(!options.pixel_size.empty())
+	{
+		terms.push_back("pixel_size = ?");
+		params.add(options.pixel_size);
+	}
+	if(!options.exif_size.empty())
+	{
+		terms.push_back("exif_size = ?");
+		params.add(options.exif_size);
+	}
+
+	if(options.min_width)
+	{
+		terms.push_back("CAST(pixel_size AS INTEGER) >= ?");
+		params.add(static_cast<int64_t>(options.min_width));
+	}
+	if(options.min_height)
+	{
+		terms.push_back("CAST(substr(pixel_size, instr(pixel_size, ',') + 1) AS INTEGER) >= ?");
+		params.add(static_cast<int64_t>(options.min_height));
+	}
+
+	std::string where;
+	for(auto& term : terms)
+		where += (where.empty() ? " WHERE " : " AND ") + term;
+	return where;
+}
+
+std::string query_sql(const std::vector<std::string>& roots, const query_options& options, query_params_t& params)
+{
+	auto where = query_where(roots, options, params);
+	if(options.count)
+		return "SELECT count(*) FROM photos" + where;
+	return "SELECT path, file_name, timestamp, size, pixel_size FROM photos" + where + " ORDER BY timestamp";
+}
+
+void query_rows(db_t::statement_t<>& select, const query_options& options, writer_t& out)
+{
+	if(options.count)
+	{
+		auto x = [&out](const std::tuple<int64_t>& t)
+		{
+			out.put(std::get<0>(t)).put('\n');
+		};
+		select.query<decltype(x), int64_t>(x);
+		return;
+	}
+
+	auto x = [&out](const std::tuple<db_t::text_t, db_t::text_t, db_t::text_t, int64_t, db_t::text_t>& t)
+	{
+		out.put(std::get<0>(t).data, std::get<0>(t).size).put('/').put(std::get<1>(t).data, std::get<1>(t).size).put('\t');
+		out.put(std::get<2>(t).data, std::get<2>(t).size).put('\t');
+		out.put(std::get<3>(t)).put('\t');
+		out.put(std::get<4>(t).data, std::get<4>(t).size).put('\n');
+	};
+	select.query<decltype(x), db_t::text_t, db_t::text_t, db_t::text_t, int64_t, db_t::text_t>(x);
+}
+
+bool query_db(db_t& db, const std::vector<std::string>& roots, const query_options& options)
+{
+	query_params_t params;
+	db_t::statement_t<> select{db, query_sql(roots, options, params)};
+	params.bind(select);
+	writer_t out(stdout);
+	query_rows(select, options, out);
+	if(int error = out.finish())
+	{
+		std::cerr << "query: " << strerror(error) << "\n";
+		return false;
+	}
+	return true;
+}
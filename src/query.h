@@ -0,0 +1,88 @@
+/*
+ * query.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef QUERY_H_
+#define QUERY_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "db.h"
+
+class writer_t;
+
+struct query_options
+{
+	// timestamp prefixes, both inclusive: 2019, 2019-07, 2019-07-14 ...
+	std::string from;
+	std::string to;
+
+	// directory, relative to each root unless absolute; includes
+	// subdirectories.
+	std::string path;
+
+	// bytes; 0 for no bound.
+	uint64_t min_size;
+	uint64_t max_size;
+
+	// exact dimensions as width,height.
+	std::string pixel_size;
+	std::string exif_size;
+
+	// lower bounds on the pixel dimensions.
+	long min_width;
+	long min_height;
+
+	// photos of one event; see events_db().
+	int64_t event;
+
+	// print only the number of matches.
+	bool count;
+
+	query_options();
+};
+
+// Values for the ? of a query_where() clause, in order.
+class query_params_t
+{
+private:
+	struct param_t
+	{
+		bool text;
+		std::string s;
+		int64_t n;
+	};
+	std::vector<param_t> params;
+public:
+	query_params_t& add(const std::string& s);
+	query_params_t& add(int64_t n);
+
+	void bind(db_t::statement_t<>& stmt) const;
+};
+
+// Reads a --name=value argument into options; false if it is not one.
+// Throws std::invalid_argument for a value that is not a number.
+bool parse_query_option(const std::string& arg, query_options& options);
+
+// s as an SQL string literal.
+std::string sql_quote(const std::string& s);
+
+/*
+ * The WHERE clause (or nothing) selecting the photos that match, with the
+ * values as parameters, so the same filters with other values make the same
+ * statement.
+ */
+std::string query_where(const std::vector<std::string>& roots, const query_options& options, query_params_t& params);
+
+// The select that query_db() runs.
+std::string query_sql(const std::vector<std::string>& roots, const query_options& options, query_params_t& params);
+
+// Runs a select from query_sql() and writes what query_db() would.
+void query_rows(db_t::statement_t<>& select, const query_options& options, writer_t& out);
+
+// Lists matching photos, oldest first, one per line.
+bool query_db(db_t& db, const std::vector<std::string>& roots, const query_options& options);
+
+#endif /* QUERY_H_ */
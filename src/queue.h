@@ -0,0 +1,81 @@
+/*
+ * queue.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/*
+ * Hands items from one thread to another, blocking the producer while the
+ * items queued cost more than limit (0 for no limit).
+ */
+template <typename T>
+class bounded_queue_t
+{
+private:
+	std::mutex m;
+	std::condition_variable cv;
+	std::deque<std::pair<T, std::size_t> > items;
+	std::size_t used;
+	std::size_t limit;
+	bool finished;
+	bool closed;
+public:
+	explicit bounded_queue_t(std::size_t limit)
+	 : used(0), limit(limit), finished(false), closed(false)
+	{
+	}
+
+	// False once the consumer has gone.
+	bool push(const T& item, std::size_t cost)
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [&]{ return closed || !limit || items.empty() || used + cost <= limit; });
+		if(closed)
+			return false;
+		items.emplace_back(item, cost);
+		used += cost;
+		cv.notify_all();
+		return true;
+	}
+
+	// Waits for an item if wait is set; false when there is none to be had.
+	bool pop(T& item, bool wait)
+	{
+		std::unique_lock<std::mutex> lock(m);
+		if(wait)
+			cv.wait(lock, [this]{ return finished || !items.empty(); });
+		if(items.empty())
+			return false;
+		item = items.front().first;
+		used -= items.front().second;
+		items.pop_front();
+		cv.notify_all();
+		return true;
+	}
+
+	// No more items are coming.
+	void finish()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		finished = true;
+		cv.notify_all();
+	}
+
+	// No more items are wanted.
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(m);
+		closed = true;
+		cv.notify_all();
+	}
+};
+
+#endif /* QUEUE_H_ */
@@ -0,0 +1,208 @@
+/*
+ * reader.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "reader.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mmap.h"
+#include "util.h"
+
+namespace
+{
+
+const std::size_t direct_align = 4096;
+
+// Pieces are copied out of the mapping so that a file truncated under it
+// fails the copy rather than the caller; see copy_mapped().
+void read_map(const std::string& filename, const read_options& options, const std::function<void(const void*, std::size_t)>& func)
+{
+	mmap_t addr(filename.c_str(), options.map_hints);
+
+	std::unique_ptr<char[]> buf(new char[options.buffer]);
+	const char* base = static_cast<const char*>(static_cast<void*>(addr));
+	const std::size_t size = addr.length();
+	for(std::size_t offset = 0; offset < size; offset += options.buffer)
+	{
+		std::size_t length = std::min(options.buffer, size - offset);
+		copy_mapped(buf.get(), base + offset, length);
+		func(buf.get(), length);
+		addr.release(offset, length);
+	}
+}
+
+void read_stream(int fd, const read_options& options, const std::function<void(const void*, std::size_t)>& func)
+{
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	std::unique_ptr<char[]> buf(new char[options.buffer]);
+	off_t offset(0);
+	while(true)
+	{
+		ssize_t n = read(fd, buf.get(), options.buffer);
+		throw_if(n == -1, strerror(errno));
+		if(n == 0)
+			break;
+
+		func(buf.get(), n);
+		posix_fadvise(fd, offset, n, POSIX_FADV_DONTNEED);
+		offset += n;
+	}
+
+	// Pages still in flight from readahead were skipped above.
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+// One thread reads into one buffer while the caller consumes the other.
+void read_direct(int fd, const read_options& options, const std::function<void(const void*, std::size_t)>& func)
+{
+	auto free_buffer = [](char* p){ free(p); };
+	typedef std::unique_ptr<char, decltype(free_buffer)> buffer_t;
+
+	const std::size_t length = (std::max(options.buffer, direct_align) + direct_align - 1) & ~(direct_align - 1);
+	struct slot
+	{
+		buffer_t data;
+		ssize_t length;
+		bool full;
+	};
+	slot slots[2] = {{buffer_t(nullptr, free_buffer), 0, false}, {buffer_t(nullptr, free_buffer), 0, false}};
+
+	// A short read is the end of the file; reading on from an unaligned
+	// offset would fail.
+	for(auto& s : slots)
+	{
+		void* p;
+		throw_if(posix_memalign(&p, direct_align, length) != 0, "Unable to allocate read buffer");
+		s.data.reset(static_cast<char*>(p));
+	}
+
+	std::mutex m;
+	std::condition_variable cv;
+	bool cancelled(false);
+	int error(0);
+
+	std::thread reader([&]
+	{
+		off_t offset(0);
+		for(int i = 0; ; i ^= 1)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m);
+				cv.wait(lock, [&]{ return !slots[i].full || cancelled; });
+				if(cancelled)
+					return;
+			}
+
+			ssize_t n = pread(fd, slots[i].data.get(), length, offset);
+			int err = errno;
+
+			std::lock_guard<std::mutex> lock(m);
+			slots[i].length = n;
+			slots[i].full = true;
+			if(n == -1)
+				error = err;
+			cv.notify_all();
+			if(n < static_cast<ssize_t>(length))
+				return;
+			offset += n;
+		}
+	});
+
+	auto finish = [&]
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			cancelled = true;
+			cv.notify_all();
+		}
+		reader.join();
+	};
+
+	try
+	{
+		for(int i = 0; ; i ^= 1)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m);
+				cv.wait(lock, [&]{ return slots[i].full; });
+			}
+
+			if(slots[i].length == -1)
+				throw std::runtime_error(strerror(error));
+			if(slots[i].length == 0)
+				break;
+
+			func(slots[i].data.get(), slots[i].length);
+			if(slots[i].length < static_cast<ssize_t>(length))
+				break;
+
+			std::lock_guard<std::mutex> lock(m);
+			slots[i].full = false;
+			cv.notify_all();
+		}
+	}
+	catch(...)
+	{
+		finish();
+		throw;
+	}
+	finish();
+}
+
+}
+
+read_options::read_options()
+ : mode(map), map_hints(mmap_t::sequential | mmap_t::willneed), buffer(1 << 20), threads(1), depth(32), hash(hasher_t::sha1), tree(0), chunk(16 << 20)
+{
+}
+
+bool parse_read_mode(const std::string& s, read_options::mode_t& mode)
+{
+	if(s == "map")
+		mode = read_options::map;
+	else if(s == "stream")
+		mode = read_options::stream;
+	else if(s == "direct")
+		mode = read_options::direct;
+	else if(s == "uring")
+		mode = read_options::uring;
+	else
+		return false;
+	return true;
+}
+
+void read_file(const std::string& filename, const read_options& options, const std::function<void(const void*, std::size_t)>& func)
+{
+	if(options.mode == read_options::map || options.mode == read_options::uring)
+		return read_map(filename, options, func);
+
+	if(options.mode == read_options::direct)
+	{
+		std::unique_ptr<fd_t> fd;
+		try
+		{
+			fd.reset(new fd_t(filename.c_str(), O_RDONLY | O_DIRECT));
+		}
+		catch(const std::runtime_error&)
+		{
+			// Not every filesystem (tmpfs) takes O_DIRECT; stream instead.
+		}
+		if(fd)
+			return read_direct(*fd, options, func);
+	}
+
+	fd_t fd(filename.c_str(), O_RDONLY);
+	read_stream(fd, options, func);
+}
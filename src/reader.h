@@ -0,0 +1,62 @@
+/*
+ * reader.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef READER_H_
+#define READER_H_
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "hash.h"
+
+struct read_options
+{
+	enum mode_t
+	{
+		map,	// mmap_t with map_hints
+		stream,	// read() and drop each piece from the page cache behind us
+		direct,	// O_DIRECT, double buffered; never touches the page cache
+		uring	// io_uring, many files at once; see read_photos()
+	} mode;
+
+	int map_hints;
+
+	// bytes per read for stream, direct and uring, and per piece copied out
+	// of the mapping for map.
+	std::size_t buffer;
+
+	// hash/exif workers, and reads kept in flight by uring.
+	unsigned threads;
+	unsigned depth;
+
+	// what checksums are taken with.
+	hasher_t::algorithm_t hash;
+
+	// files of at least tree bytes (0 for none) are hashed as chunk sized
+	// pieces across the threads; see tree_hash().
+	uint64_t tree;
+	uint64_t chunk;
+
+	// file the smallest embedded preview of each new photo is appended to
+	// during the exif pass; empty for none. See thumbnails_t.
+	std::string thumbnails;
+
+	read_options();
+};
+
+// Parses map, stream, direct or uring; false if unknown.
+bool parse_read_mode(const std::string& s, read_options::mode_t& mode);
+
+/*
+ * Passes the content of a file to func in order, a piece at a time, up to
+ * wherever the file ends by the time it is read.
+ * uring only applies to batches; a single file is mapped.
+ * Throws std::runtime_error if the file cannot be read, including if it is
+ * truncated while mapped.
+ */
+void read_file(const std::string& filename, const read_options& options, const std::function<void(const void*, std::size_t)>& func);
+
+#endif /* READER_H_ */
@@ -0,0 +1,571 @@
+/*
+ * scan.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "scan.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <dirent.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "dirs.h"
+#include "engine.h"
+#include "extent.h"
+#include "ingest.h"
+#include "metrics.h"
+#include "photo.h"
+#include "queue.h"
+#include "schema.h"
+#include "thumbs.h"
+#include "timestamp.h"
+
+struct walk_t
+{
+	const dir_cache_t& cache;
+	bool full;
+
+	// Directories an interrupted scan had finished, when resuming.
+	const dir_cache_t* resumed;
+	// Called once every file of a listed (or resumed) directory has been seen.
+	std::function<bool(const dir_t&, bool resumed)> walked;
+
+	std::vector<dir_t> read;
+	std::vector<dir_t> skipped;
+	size_t skipped_files;
+
+	// Set when the walk should give up.
+	bool stop;
+};
+
+template <typename Fn>
+bool enumerate_directory(walk_t& walk, const std::string& path, const std::string& parent, Fn func)
+{
+	struct stat sb;
+	if(stat(path.c_str(), &sb) != 0)
+	{
+		std::cerr << "Unable to stat directory '" << path << "'\n";
+		return false;
+	}
+
+	dir_t current{path, parent, sb};
+	if(!walk.full)
+	{
+		if(auto cached = walk.cache.unchanged(current))
+		{
+			walk.skipped.push_back(*cached);
+			walk.skipped_files += cached->entries;
+			for(auto& subdir : walk.cache.subdirs(path))
+				if(!enumerate_directory(walk, subdir, path, func))
+					return false;
+			return true;
+		}
+	}
+
+	// Finished by an interrupted scan: its files were matched then, but its
+	// subdirectories may not all have been reached.
+	const dir_t* done = walk.resumed ? walk.resumed->unchanged(current) : nullptr;
+
+	// List first and close the directory before descending, so deep trees
+	// do not hold a descriptor per level.
+	std::vector<std::pair<std::string, unsigned char> > entries;
+	{
+		metrics_t::timer_t timer(metrics(), metrics_t::walk);
+
+		auto delete_dir = [](DIR* d){ closedir(d); };
+		std::unique_ptr<DIR, decltype(delete_dir)> dir(opendir(path.c_str()), delete_dir);
+		if (!dir)
+		{
+			std::cerr << "Unable to open directory '" << path << "'\n";
+			return false;
+		}
+
+		dirent entry;
+		dirent *result;
+		for (int res = readdir_r(dir.get(), &entry, &result); result != nullptr && res == 0; res = readdir_r(dir.get(), &entry, &result))
+			entries.emplace_back(entry.d_name, entry.d_type);
+	}
+
+	// A directory with a file that could not be stat()ed is still recorded,
+	// so its parent lists it, but is read again next time.
+	bool complete(true);
+
+	std::vector<std::string> subdirs;
+	for(auto& entry : entries)
+	{
+		auto& name = entry.first;
+		if(entry.second == DT_DIR)
+		{
+			if(name != "." && name != "..")
+				subdirs.push_back(path + '/' + name);
+		}
+		else if(entry.second == DT_REG && !done)
+		{
+			if(parent.empty() && catalog_file(name))
+				continue;
+			++current.entries;
+			if(!func({name, path}))
+				complete = false;
+			if(walk.stop)
+				return false;
+		}
+	}
+
+	if(done)
+	{
+		walk.read.push_back(*done);
+		if(!walk.walked(*done, true))
+			return false;
+	}
+	else
+	{
+		if(!complete)
+			current.invalidate();
+		walk.read.push_back(current);
+		if(!walk.walked(current, false))
+			return false;
+	}
+
+	for(auto& subdir : subdirs)
+		if(!enumerate_directory(walk, subdir, path, func))
+			return false;
+	return true;
+}
+
+namespace
+{
+
+// Removes rows not stamped by the current rebuild.
+int prune(db_t& db, const std::string& rebuilt)
+{
+	db_t::statement_t<std::string, std::string> prune_photos{db, "DELETE FROM photos WHERE rebuilt < ? OR rebuilt > ?"};
+	db_t::statement_t<std::string, std::string> prune_dirs{db, "DELETE FROM dirs WHERE rebuilt < ? OR rebuilt > ?"};
+	db_t::statement_t<> prune_chunks{db, "DELETE FROM chunks WHERE NOT EXISTS (SELECT 1 FROM photos WHERE photos.checksum = chunks.checksum AND photos.hash = chunks.hash)"};
+
+	db.execute("BEGIN");
+	prune_photos.execute(rebuilt, rebuilt);
+	int pruned = sqlite3_changes(db);
+	prune_dirs.execute(rebuilt, rebuilt);
+	if(pruned)
+		prune_chunks.execute();
+	db.execute("COMMIT");
+	return pruned;
+}
+
+// A file found by the walk, or (without a photo) a directory it finished.
+struct walk_item
+{
+	std::shared_ptr<photo_t> photo;
+	dir_t dir;
+	bool resumed;
+
+	// Roughly what the item holds on to.
+	size_t cost() const
+	{
+		if(photo)
+			return sizeof(walk_item) + sizeof(photo_t) + photo->file_name.capacity() + photo->path.capacity();
+		return sizeof(walk_item) + dir.path.capacity() + dir.parent.capacity();
+	}
+};
+
+// Builds a line and writes it in one go, so that lines from scans running
+// side by side do not interleave.
+class line_t
+{
+private:
+	std::ostream& os;
+	std::ostringstream s;
+public:
+	line_t(std::ostream& os, const std::string& prefix)
+	 : os(os)
+	{
+		s << prefix;
+	}
+
+	template <typename T>
+	line_t& operator<<(const T& value)
+	{
+		s << value;
+		return *this;
+	}
+
+	~line_t()
+	{
+		os << s.str() << std::flush;
+	}
+};
+
+void report_metrics(const scan_options& options)
+{
+	metrics().report(std::cerr);
+	if(!options.metrics_file.empty())
+	{
+		std::ofstream os(options.metrics_file);
+		metrics().write_json(os);
+		if(!os)
+			std::cerr << options.metrics_file << ": Unable to write metrics\n";
+	}
+}
+
+}
+
+scan_options::scan_options()
+ : full(false), resume(false), order(physical), readahead(64 << 20), memory(0), thumbnails(false), shared(false)
+{
+}
+
+bool catalog_file(const std::string& name)
+{
+	auto starts = [&name](const char* prefix)
+	{
+		return name.compare(0, strlen(prefix), prefix) == 0;
+	};
+	return starts("photo.db") || starts("photo.snap") || name == "photo.thumbs" || name == "photo.sock";
+}
+
+bool rebuild_db(db_t& db, const std::string& src, scan_options options)
+{
+	if(options.thumbnails)
+		options.read.thumbnails = thumbnails_file(src);
+
+	timestamp_t rebuilt(time(nullptr));
+	const std::string who = options.shared ? src + ": " : std::string();
+	if(!options.shared)
+		metrics().reset();
+
+	checkpoint_t checkpoint{db};
+	std::unique_ptr<dir_cache_t> resumed;
+	std::multimap<std::string, photo_t> queued;
+	{
+		std::string stamp;
+		if(checkpoint.interrupted(stamp))
+		{
+			if(options.resume)
+			{
+				rebuilt = timestamp_t{stamp};
+				resumed.reset(new dir_cache_t{db, "scan_dirs"});
+				queued = checkpoint.queued();
+				line_t(std::cerr, who) << "Resuming scan of " << stamp << " with " << queued.size() << " files to read.\n";
+			}
+			else
+			{
+				line_t(std::cerr, who) << "Starting over; --resume continues an interrupted scan.\n";
+			}
+		}
+	}
+
+	// update db.
+	db.execute("PRAGMA synchronous = OFF");
+
+	// Scans before catalog_file() indexed them.
+	{
+		db_t::statement_t<std::string> remove_catalog{db, "DELETE FROM photos WHERE path = ? AND (file_name GLOB 'photo.db*' OR file_name GLOB 'photo.snap*' OR file_name = 'photo.thumbs' OR file_name = 'photo.sock')"};
+		remove_catalog.execute(src);
+	}
+	checkpoint.start(rebuilt.str());
+
+	ingest_t ingest{db, rebuilt, options.read};
+
+	dir_cache_t cache{db};
+
+	// Half the memory ceiling for files the walk has found, half for the new
+	// ones waiting to be read. Without a ceiling every new file is read once
+	// the walk is done, in one physical order.
+	const size_t limit = options.memory / 2;
+	bounded_queue_t<walk_item> found(limit);
+
+	// The walk runs ahead on its own thread; everything touching the db
+	// stays on this one.
+	size_t failed(0);
+	bool walk_ok(false);
+	walk_t walk{cache, options.full, resumed.get(), [&found](const dir_t& dir, bool from_checkpoint)
+	{
+		walk_item item{nullptr, dir, from_checkpoint};
+		return found.push(item, item.cost());
+	}, {}, {}, 0, false};
+
+	std::thread walker([&]
+	{
+		walk_ok = enumerate_directory(walk, src, {}, [&](photo_t photo)
+		{
+			{
+				metrics_t::timer_t timer(metrics(), metrics_t::stat);
+				if(!stat(photo))
+				{
+					++failed;
+					return false;
+				}
+			}
+
+			walk_item item{std::make_shared<photo_t>(photo), {}, false};
+			if(!found.push(item, item.cost()))
+				walk.stop = true;
+			return true;
+		});
+		found.finish();
+	});
+
+	struct join_t
+	{
+		bounded_queue_t<walk_item>& found;
+		std::thread& walker;
+		~join_t()
+		{
+			found.close();
+			if(walker.joinable())
+				walker.join();
+		}
+	} join{found, walker};
+
+	size_t files(0);
+	size_t stat_old(0);
+	size_t stat_moved(0);
+	size_t stat_new(0);
+
+	// New files waiting to be read.
+	std::vector<std::pair<extent_key, std::shared_ptr<photo_t> > > pending;
+	size_t pending_cost(0);
+
+	auto match = [&](const std::shared_ptr<photo_t>& photo)
+	{
+		++files;
+
+		ingest_t::status status;
+		{
+			metrics_t::timer_t timer(metrics(), metrics_t::lookup);
+			status = ingest.match(*photo);
+		}
+
+		switch(status)
+		{
+			case ingest_t::added:
+				pending.emplace_back(extent_key{false, photo->ino}, photo);
+				pending_cost += walk_item{photo, {}, false}.cost();
+				checkpoint.queue(*photo);
+				break;
+			case ingest_t::moved:
+				++stat_moved;
+				++stat_old;
+				break;
+			case ingest_t::old:
+				++stat_old;
+				break;
+		}
+	};
+
+	double read_seconds(0);
+	uint64_t bytes(0);
+	size_t read_files(0);
+
+	// Directories holding a file that could not be hashed; the next scan
+	// lists them again and reads it.
+	size_t unhashed(0);
+	std::set<std::string> unhashed_dirs;
+
+	auto stored = [&](photo_t& photo)
+	{
+		if(photo.checksum.empty())
+		{
+			++unhashed;
+			unhashed_dirs.insert(photo.path);
+			return;
+		}
+
+		ingest.store(photo);
+		checkpoint.done(photo);
+		bytes += photo.size;
+
+		if(++stat_new % 100 == 0)
+		{
+			line_t(std::cout, who) << "new: " << stat_new << "; old: " << stat_old << "\n";
+		}
+	};
+
+	// Reads and stores what is pending, in physical order if asked.
+	auto read_pending = [&]
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		if(options.order == scan_options::physical)
+		{
+			for(auto& p : pending)
+				p.first = physical_offset(p.second->full_filename(), p.second->ino);
+			std::stable_sort(begin(pending), end(pending), [](const std::pair<extent_key, std::shared_ptr<photo_t> >& l, const std::pair<extent_key, std::shared_ptr<photo_t> >& r)
+			{
+				return l.first < r.first;
+			});
+		}
+
+		// Files big enough for a tree hash go last, one at a time, each with
+		// every thread to itself.
+		size_t count = pending.size();
+		if(options.read.tree)
+		{
+			count = std::stable_partition(begin(pending), end(pending), [&options](const std::pair<extent_key, std::shared_ptr<photo_t> >& p)
+			{
+				return p.second->size < options.read.tree;
+			}) - begin(pending);
+		}
+
+		if(options.read.mode == read_options::uring || options.read.threads > 1)
+		{
+			std::vector<photo_t*> photos;
+			for(size_t i = 0; i < count; ++i)
+				photos.push_back(pending[i].second.get());
+			read_photos(photos, options.read, stored);
+		}
+		else
+		{
+			// Keep up to readahead bytes of the files after this one on their way in.
+			uint64_t prefetched(0);
+			size_t ahead(0);
+
+			for(size_t i = 0; i < count; ++i)
+			{
+				auto& photo = *pending[i].second;
+				prefetched -= std::min<uint64_t>(prefetched, photo.size);
+				for(ahead = std::max(ahead, i + 1); ahead < count && prefetched < options.readahead; ++ahead)
+				{
+					auto& next = *pending[ahead].second;
+					prefetch(next.full_filename(), next.size);
+					prefetched += next.size;
+				}
+
+				ingest.read(photo);
+				stored(photo);
+			}
+		}
+
+		for(size_t i = count; i < pending.size(); ++i)
+		{
+			auto& photo = *pending[i].second;
+			ingest.read(photo);
+			stored(photo);
+		}
+
+		read_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		read_files += pending.size();
+		pending.clear();
+		pending_cost = 0;
+	};
+
+	// With a ceiling, read whenever the walk has nothing new or the pending
+	// files reach their share; hashing then overlaps the walk.
+	for(walk_item item; ; )
+	{
+		bool got = found.pop(item, !limit || pending.empty());
+		if(!got && !pending.empty())
+		{
+			read_pending();
+			continue;
+		}
+		if(!got)
+			break;
+
+		if(item.photo)
+		{
+			match(item.photo);
+		}
+		else
+		{
+			// Files the interrupted scan had still to read; anything gone or
+			// changed since is picked up by the next scan.
+			if(item.resumed)
+			{
+				auto range = queued.equal_range(item.dir.path);
+				for(auto it = range.first; it != range.second; ++it)
+				{
+					auto photo = std::make_shared<photo_t>(it->second.file_name, it->second.path);
+					if(stat(*photo) && photo->size == it->second.size && photo->mtime.str() == it->second.mtime.str())
+						match(photo);
+				}
+			}
+			checkpoint.walked(item.dir);
+		}
+
+		if(limit && pending_cost >= limit)
+			read_pending();
+	}
+	read_pending();
+	checkpoint.commit();
+
+	found.close();
+	walker.join();
+	if(!walk_ok)
+		return false;
+
+	line_t(std::cerr, who) << files << " Files.\n";
+	if(!walk.skipped.empty())
+		line_t(std::cerr, who) << walk.skipped_files << " Files in " << walk.skipped.size() << " unchanged directories.\n";
+
+	line_t(std::cout, who) << "new: " << stat_new << "; old: " << stat_old << "; moved: " << stat_moved << "\n";
+	if(read_files)
+		line_t(std::cout, who) << "read: " << (bytes >> 20) << " MB in " << read_seconds << "s (" << bytes / 1048576.0 / std::max(read_seconds, 1e-9) << " MB/s, " << read_files / std::max(read_seconds, 1e-9) << " files/s)\n";
+
+	for(auto& dir : walk.read)
+		if(unhashed_dirs.count(dir.path))
+			dir.invalidate();
+	dir_cache_t::store(db, rebuilt.str(), walk.read, walk.skipped);
+
+	if(!options.shared)
+		report_metrics(options);
+
+	// Everything present has now been stamped; the rest is gone.
+	if(failed || unhashed)
+		line_t(std::cerr, who) << failed + unhashed << " Files could not be read; not pruning.\n";
+	else
+		line_t(std::cout, who) << "pruned: " << prune(db, rebuilt.str()) << "\n";
+
+	checkpoint.finish();
+	return true;
+}
+
+bool rebuild_roots(const std::vector<std::string>& roots, const scan_options& options)
+{
+	if(roots.size() == 1)
+	{
+		db_t db{roots[0] + "/photo.db"};
+		create_schema(db);
+		return rebuild_db(db, roots[0], options);
+	}
+
+	scan_options shared = options;
+	shared.shared = true;
+	metrics().reset();
+
+	std::vector<char> ok(roots.size());
+	std::vector<std::thread> scans;
+	for(size_t i = 0; i < roots.size(); ++i)
+	{
+		scans.emplace_back([&, i]
+		{
+			try
+			{
+				db_t db{roots[i] + "/photo.db"};
+				create_schema(db);
+				ok[i] = rebuild_db(db, roots[i], shared);
+			}
+			catch(const std::exception& ex)
+			{
+				line_t(std::cerr, roots[i] + ": ") << ex.what() << "\n";
+			}
+		});
+	}
+	for(auto& scan : scans)
+		scan.join();
+
+	report_metrics(options);
+	return std::find(begin(ok), end(ok), false) == end(ok);
+}
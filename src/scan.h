@@ -0,0 +1,65 @@
+/*
+ * scan.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SCAN_H_
+#define SCAN_H_
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "db.h"
+#include "reader.h"
+
+struct scan_options
+{
+	// stat every file, even in unchanged directories.
+	bool full;
+
+	// continue a scan that was interrupted, rather than starting over.
+	bool resume;
+
+	enum order_t
+	{
+		directory,	// as enumerated
+		physical	// by first extent on disk
+	} order;
+
+	// bytes of upcoming files to prefetch while reading new photos.
+	std::size_t readahead;
+
+	// how files are read for hashing.
+	read_options read;
+
+	// bytes the walk may hold in found and unread files before the reads
+	// catch up, so hashing overlaps the walk; 0 reads everything after it.
+	std::size_t memory;
+
+	// where to write the phase metrics as JSON, if anywhere.
+	std::string metrics_file;
+
+	// keep embedded previews; see read_options::thumbnails.
+	bool thumbnails;
+
+	// one of several scans running at once: its lines are marked with src
+	// and the metrics are reset and reported by whoever started them.
+	bool shared;
+
+	scan_options();
+};
+
+// Whether a file at the top of src is one of photodb's own: the db and its
+// journals, thumbnails, snapshot and socket. They are never indexed.
+bool catalog_file(const std::string& name);
+
+bool rebuild_db(db_t& db, const std::string& src, scan_options options);
+
+/*
+ * Scans each root into its own photo.db, all at once, each with its own
+ * walk and reader threads, so that roots on different disks are read side
+ * by side.
+ */
+bool rebuild_roots(const std::vector<std::string>& roots, const scan_options& options);
+
+#endif /* SCAN_H_ */
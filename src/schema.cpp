@@ -0,0 +1,106 @@
+/*
+ * schema.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "schema.h"
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace
+{
+
+int user_version(db_t& db)
+{
+	int version(0);
+	db_t::statement_t<> select_version{db, "PRAGMA user_version"};
+	auto x = [&version](const std::tuple<int>& t)
+	{
+		version = std::get<0>(t);
+	};
+	select_version.query<decltype(x), int>(x);
+	return version;
+}
+
+const int schema_version = 5;
+
+}
+
+void check_schema(db_t& db)
+{
+	int version = user_version(db);
+	if(version != schema_version)
+		throw std::runtime_error("schema version " + std::to_string(version) + " where " + std::to_string(schema_version) + " is needed; scan it (or run any other command on it) first");
+}
+
+void create_schema(db_t& db)
+{
+	db.execute("CREATE TABLE IF NOT EXISTS photos (file_name TEXT, path TEXT, size INTEGER, mtime TEXT, timestamp TEXT, checksum TEXT, pixel_size TEXT, exif_size TEXT, rebuilt TEXT)");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_idx ON photos (file_name, path, size, mtime)");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_path_idx ON photos (path)");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_rebuilt_idx ON photos (rebuilt)");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_timestamp_idx ON photos (timestamp)");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_size_idx ON photos (size)");
+	db.execute("CREATE TABLE IF NOT EXISTS dirs (path TEXT PRIMARY KEY, parent TEXT, mtime INTEGER, nlink INTEGER, entries INTEGER, rebuilt TEXT)");
+	db.execute("CREATE INDEX IF NOT EXISTS dirs_parent_idx ON dirs (parent)");
+
+	// Chunk digests of tree checksums; see tree_hash().
+	db.execute("CREATE TABLE IF NOT EXISTS chunks (hash TEXT, checksum TEXT, idx INTEGER, offset INTEGER, length INTEGER, chunk TEXT, PRIMARY KEY (hash, checksum, idx))");
+	db.execute("CREATE INDEX IF NOT EXISTS photos_checksum_idx ON photos (checksum)");
+
+	// Progress of an unfinished scan; see checkpoint_t.
+	db.execute("CREATE TABLE IF NOT EXISTS scan_state (rebuilt TEXT)");
+	db.execute("CREATE TABLE IF NOT EXISTS scan_dirs (path TEXT PRIMARY KEY, parent TEXT, mtime INTEGER, nlink INTEGER, entries INTEGER)");
+	db.execute("CREATE TABLE IF NOT EXISTS scan_queue (path TEXT, file_name TEXT, size INTEGER, mtime TEXT, dev INTEGER, ino INTEGER, PRIMARY KEY (path, file_name))");
+
+	// Photos grouped by time; see events_db().
+	db.execute("CREATE TABLE IF NOT EXISTS events (id INTEGER PRIMARY KEY, start TEXT, end TEXT, first INTEGER, last INTEGER, photos INTEGER)");
+	db.execute("CREATE INDEX IF NOT EXISTS events_first_idx ON events (first)");
+	db.execute("CREATE TABLE IF NOT EXISTS event_state (gap INTEGER)");
+
+	int version = user_version(db);
+	if(version < 1)
+	{
+		db.execute("ALTER TABLE photos ADD COLUMN dev INTEGER");
+		db.execute("ALTER TABLE photos ADD COLUMN ino INTEGER");
+		db.execute("CREATE INDEX photos_inode_idx ON photos (dev, ino)");
+	}
+
+	if(version < 2)
+	{
+		// Everything before was SHA-1.
+		db.execute("ALTER TABLE photos ADD COLUMN hash TEXT");
+		db.execute("UPDATE photos SET hash = 'sha1' WHERE checksum > ''");
+	}
+
+	if(version < 3)
+	{
+		db.execute("ALTER TABLE photos ADD COLUMN verified TEXT");
+		db.execute("ALTER TABLE photos ADD COLUMN verify_status TEXT");
+		db.execute("CREATE INDEX photos_verified_idx ON photos (verified)");
+	}
+
+	if(version < 4)
+	{
+		// Embedded previews; see thumbnails_t.
+		db.execute("ALTER TABLE photos ADD COLUMN thumbnail INTEGER");
+		db.execute("ALTER TABLE photos ADD COLUMN thumbnail_size INTEGER");
+	}
+
+	if(version < 5)
+	{
+		// Words of file names and paths; see search_db(). The index reads
+		// the text from photos and the triggers keep it in step with every
+		// insert, move and delete.
+		db.execute("CREATE VIRTUAL TABLE photos_fts USING fts4 (content=\"photos\", file_name, path, tokenize=unicode61)");
+		db.execute("CREATE TRIGGER photos_fts_bd BEFORE DELETE ON photos BEGIN DELETE FROM photos_fts WHERE docid = old.rowid; END");
+		db.execute("CREATE TRIGGER photos_fts_bu BEFORE UPDATE OF file_name, path ON photos BEGIN DELETE FROM photos_fts WHERE docid = old.rowid; END");
+		db.execute("CREATE TRIGGER photos_fts_au AFTER UPDATE OF file_name, path ON photos BEGIN INSERT INTO photos_fts (docid, file_name, path) VALUES (new.rowid, new.file_name, new.path); END");
+		db.execute("CREATE TRIGGER photos_fts_ai AFTER INSERT ON photos BEGIN INSERT INTO photos_fts (docid, file_name, path) VALUES (new.rowid, new.file_name, new.path); END");
+		db.execute("INSERT INTO photos_fts (photos_fts) VALUES ('rebuild')");
+	}
+
+	db.execute("PRAGMA user_version = " + std::to_string(schema_version));
+}
@@ -0,0 +1,18 @@
+/*
+ * schema.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SCHEMA_H_
+#define SCHEMA_H_
+#include "db.h"
+
+// Creates the tables, upgrading a db written by an older version.
+void create_schema(db_t& db);
+
+// For a db only read: throws std::runtime_error unless its tables are those
+// create_schema() makes.
+void check_schema(db_t& db);
+
+#endif /* SCHEMA_H_ */
@@ -0,0 +1,111 @@
+/*
+ * search.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "search.h"
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "output.h"
+
+namespace
+{
+
+// Per photos_fts column: file_name, path.
+const double weights[] = {4.0, 1.0};
+
+struct result_t
+{
+	double score;
+	int64_t id;
+
+	bool operator<(const result_t& r) const
+	{
+		return score > r.score || (score == r.score && id < r.id);
+	}
+};
+
+/*
+ * BM25 from matchinfo 'pcnals': phrases, columns, rows, then the average
+ * length, this row's length and the longest run of phrases matched in order
+ * for each column. The run stands in for the hits, and as every row matches
+ * every word of a plain query, word rarity is left out: counting the hits of
+ * each word in all rows ('x') reads the whole index entry of words like IMG
+ * and is most of the cost of a search.
+ */
+double rank(const uint32_t* info, std::size_t n)
+{
+	const double k1 = 1.2;
+	const double b = 0.75;
+
+	if(n < 3 || n < 3 + 3 * static_cast<std::size_t>(info[1]))
+		return 0;
+	const uint32_t columns = info[1];
+	const uint32_t* average = info + 3;
+	const uint32_t* length = average + columns;
+	const uint32_t* run = length + columns;
+
+	double score(0);
+	for(uint32_t c = 0; c < columns; ++c)
+	{
+		const double tf = run[c];
+		if(!tf)
+			continue;
+		double norm = average[c] ? length[c] / static_cast<double>(average[c]) : 1.0;
+		double weight = c < sizeof(weights) / sizeof(*weights) ? weights[c] : 1.0;
+		score += weight * tf * (k1 + 1) / (tf + k1 * (1 - b + b * norm));
+	}
+	return score;
+}
+
+}
+
+search_options::search_options()
+ : limit(20)
+{
+}
+
+bool search_db(db_t& db, const search_options& options)
+{
+	if(!options.limit)
+		return true;
+
+	// The best limit results seen, kept as a heap with the worst on top.
+	std::vector<result_t> best;
+	best.reserve(options.limit + 1);
+
+	db_t::statement_t<std::string> select_matches{db, "SELECT docid, matchinfo(photos_fts, 'pcnals') FROM photos_fts WHERE photos_fts MATCH ?"};
+	auto x = [&](const std::tuple<int64_t, db_t::blob_t>& t)
+	{
+		const db_t::blob_t& info = std::get<1>(t);
+		result_t r{rank(static_cast<const uint32_t*>(info.data), info.size / sizeof(uint32_t)), std::get<0>(t)};
+		if(best.size() == options.limit && !(r < best.front()))
+			return;
+
+		best.push_back(r);
+		std::push_heap(best.begin(), best.end());
+		if(best.size() > options.limit)
+		{
+			std::pop_heap(best.begin(), best.end());
+			best.pop_back();
+		}
+	};
+	select_matches.query<decltype(x), int64_t, db_t::blob_t>(x, options.match);
+	std::sort_heap(best.begin(), best.end());
+
+	writer_t out(stdout);
+	db_t::statement_t<int64_t> select_photo{db, "SELECT path, file_name, timestamp, size, pixel_size FROM photos WHERE rowid = ?"};
+	auto y = [&out](const std::tuple<db_t::text_t, db_t::text_t, db_t::text_t, int64_t, db_t::text_t>& t)
+	{
+		out.put(std::get<0>(t).data, std::get<0>(t).size).put('/').put(std::get<1>(t).data, std::get<1>(t).size).put('\t');
+		out.put(std::get<2>(t).data, std::get<2>(t).size).put('\t');
+		out.put(std::get<3>(t)).put('\t');
+		out.put(std::get<4>(t).data, std::get<4>(t).size).put('\n');
+	};
+	for(auto& r : best)
+		select_photo.query<decltype(y), db_t::text_t, db_t::text_t, db_t::text_t, int64_t, db_t::text_t>(y, r.id);
+	return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * search.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+#include <cstddef>
+#include <string>
+#include "db.h"
+
+struct search_options
+{
+	// FTS4 query: words, prefix*, "a phrase", file_name:word, OR, -word.
+	std::string match;
+
+	// best results printed.
+	std::size_t limit;
+
+	search_options();
+};
+
+/*
+ * Finds photos by the words of their file names and paths through the
+ * photos_fts index and prints the best as query does, best first.
+ *
+ * Words are split at anything but letters and digits, and case and accents
+ * are ignored, so IMG_1234* finds img_1234.jpg and IMG_12345.JPG. Results are
+ * ranked much as by BM25, a match in the file name counting four times one
+ * in the path and short names and paths ahead of long ones, then by row.
+ * Only the ranking reads every match; the rows themselves are looked up for
+ * the results printed.
+ */
+bool search_db(db_t& db, const search_options& options);
+
+#endif /* SEARCH_H_ */
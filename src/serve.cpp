@@ -0,0 +1,416 @@
+/*
+ * serve.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "serve.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "db.h"
+#include "output.h"
+#include "query.h"
+#include "queue.h"
+#include "schema.h"
+#include "util.h"
+
+namespace
+{
+
+// Longest request line taken; a client sending more is cut off.
+const std::size_t max_line = 64 << 10;
+
+volatile sig_atomic_t stop(false);
+
+void on_signal(int)
+{
+	stop = true;
+}
+
+/*
+ * Statements prepared on one connection, by their SQL, dropping the least
+ * recently used beyond limit.
+ */
+class statement_cache_t
+{
+private:
+	typedef db_t::statement_t<> statement_t;
+	typedef std::list<std::string> order_t;
+
+	db_t& db;
+	std::size_t limit;
+	order_t order;
+	std::unordered_map<std::string, std::pair<std::unique_ptr<statement_t>, order_t::iterator>> statements;
+public:
+	statement_cache_t(db_t& db, std::size_t limit)
+	 : db(db), limit(limit)
+	{
+	}
+
+	statement_t& get(const std::string& sql)
+	{
+		auto it = statements.find(sql);
+		if(it != statements.end())
+		{
+			order.splice(order.begin(), order, it->second.second);
+			return *it->second.first;
+		}
+
+		std::unique_ptr<statement_t> stmt(new statement_t(db, sql));
+		if(statements.size() >= std::max<std::size_t>(limit, 1))
+		{
+			statements.erase(order.back());
+			order.pop_back();
+		}
+		order.push_front(sql);
+		auto& entry = statements[sql];
+		entry.first = std::move(stmt);
+		entry.second = order.begin();
+		return *entry.first;
+	}
+
+	// After an error the statement may be left mid query.
+	void drop(const std::string& sql)
+	{
+		auto it = statements.find(sql);
+		if(it == statements.end())
+			return;
+		order.erase(it->second.second);
+		statements.erase(it);
+	}
+};
+
+bool write_all(int fd, const char* data, std::size_t size)
+{
+	while(size)
+	{
+		ssize_t n = write(fd, data, size);
+		if(n == -1 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return false;
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+std::vector<std::string> split(const std::string& line)
+{
+	const char sep = line.find('\t') != std::string::npos ? '\t' : ' ';
+	std::vector<std::string> args;
+	for(std::size_t start = 0; start <= line.size(); )
+	{
+		std::size_t end = line.find(sep, start);
+		if(end == std::string::npos)
+			end = line.size();
+		if(end > start)
+			args.push_back(line.substr(start, end - start));
+		start = end + 1;
+	}
+	return args;
+}
+
+// What query prints for one request line, or the reason it cannot be had.
+bool answer(const std::string& src, statement_cache_t& cache, const std::string& line, std::string& result)
+{
+	query_options options;
+	for(auto& arg : split(line))
+	{
+		try
+		{
+			if(!parse_query_option(arg, options))
+			{
+				result = "unknown option " + arg;
+				return false;
+			}
+		}
+		catch(const std::logic_error&)
+		{
+			result = "bad value in " + arg;
+			return false;
+		}
+	}
+
+	query_params_t params;
+	const std::string sql = query_sql({src}, options, params);
+	char* buffer(nullptr);
+	std::size_t size(0);
+	std::unique_ptr<FILE, int(*)(FILE*)> f(open_memstream(&buffer, &size), fclose);
+	if(!f)
+	{
+		result = strerror(errno);
+		return false;
+	}
+
+	// Anything thrown here would take the serving thread with it.
+	try
+	{
+		writer_t out(f.get());
+		auto& select = cache.get(sql);
+		params.bind(select);
+		query_rows(select, options, out);
+	}
+	catch(const std::exception& ex)
+	{
+		cache.drop(sql);
+		f.reset();
+		free(buffer);
+		result = ex.what();
+		return false;
+	}
+
+	f.reset();
+	result.assign(buffer, size);
+	free(buffer);
+	return true;
+}
+
+// One request line, handed from the poll loop to whichever thread is free.
+struct request_t
+{
+	int fd;
+	std::string line;
+};
+
+// A connected client, as the poll loop sees it.
+struct client_t
+{
+	std::string pending;	// read but not yet a whole line
+	bool busy;				// a thread is answering it
+
+	client_t()
+	 : busy(false)
+	{
+	}
+};
+
+// Answers were written to these clients (false if that failed).
+struct answered_t
+{
+	std::mutex m;
+	std::vector<std::pair<int, bool> > clients;
+	int wake;	// written to after each answer
+};
+
+// Answers requests on its own connection until none are coming.
+void serve_requests(const std::string& src, const std::string& filename, std::size_t cache_size, bounded_queue_t<request_t>& requests, answered_t& answered)
+{
+	db_t db{filename, true};
+	db.execute("PRAGMA busy_timeout = 5000");
+	statement_cache_t cache(db, cache_size);
+
+	std::string result;
+	for(request_t request; requests.pop(request, true); )
+	{
+		std::string header;
+		if(answer(src, cache, request.line, result))
+		{
+			header = "OK " + std::to_string(result.size()) + "\n";
+		}
+		else
+		{
+			header = "ERR " + result + "\n";
+			result.clear();
+		}
+		bool ok = write_all(request.fd, header.data(), header.size()) && write_all(request.fd, result.data(), result.size());
+
+		{
+			std::lock_guard<std::mutex> lock(answered.m);
+			answered.clients.emplace_back(request.fd, ok);
+		}
+		char c(0);
+		while(write(answered.wake, &c, 1) == -1 && errno == EINTR)
+			;
+	}
+}
+
+}
+
+serve_options::serve_options()
+ : threads(std::max(std::thread::hardware_concurrency(), 4u)), cache(64)
+{
+}
+
+bool serve_db(const std::string& src, const serve_options& options)
+{
+	const std::string filename = src + "/photo.db";
+	const std::string path = options.socket.empty() ? src + "/photo.sock" : options.socket;
+
+	// Readers then see the last commit while a scan writes the next. The
+	// mode is kept in the db, so scans from then on use it too; the -wal and
+	// -shm files it leaves beside the db are never indexed (catalog_file()).
+	{
+		db_t db{filename};
+		create_schema(db);
+		db.execute("PRAGMA journal_mode = WAL");
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, nullptr);
+	sigaction(SIGTERM, &sa, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	throw_if(path.size() >= sizeof(addr.sun_path), path + ": socket path too long");
+	strcpy(addr.sun_path, path.c_str());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	throw_if(listener == -1, strerror(errno));
+	unlink(path.c_str());
+	if(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 128) != 0)
+	{
+		std::cerr << path << ": " << strerror(errno) << "\n";
+		close(listener);
+		return false;
+	}
+	std::cerr << "Serving " << filename << " (journal mode now WAL) on " << path << "\n";
+
+	int wake[2];
+	throw_if(pipe2(wake, O_CLOEXEC | O_NONBLOCK) != 0, strerror(errno));
+	answered_t answered;
+	answered.wake = wake[1];
+
+	// One loop reads from every client and hands each whole line to a free
+	// thread, one at a time per client so answers go back in order. An idle
+	// client holds nothing but its descriptor.
+	bounded_queue_t<request_t> requests(0);
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < std::max(options.threads, 1u); ++i)
+		threads.emplace_back(serve_requests, std::cref(src), std::cref(filename), options.cache, std::ref(requests), std::ref(answered));
+
+	std::map<int, client_t> clients;
+	auto disconnect = [&clients](int fd)
+	{
+		close(fd);
+		clients.erase(fd);
+	};
+
+	// Hands on the client's next line, if it has one.
+	auto dispatch = [&](int fd, client_t& client)
+	{
+		std::size_t eol = client.pending.find('\n');
+		if(eol == std::string::npos)
+		{
+			if(client.pending.size() > max_line)
+			{
+				static const char too_long[] = "ERR request too long\n";
+				write_all(fd, too_long, sizeof(too_long) - 1);
+				disconnect(fd);
+			}
+			return;
+		}
+
+		std::string line = client.pending.substr(0, eol);
+		client.pending.erase(0, eol + 1);
+		if(!line.empty() && line.back() == '\r')
+			line.pop_back();
+		client.busy = true;
+		requests.push({fd, line}, 0);
+	};
+
+	std::vector<pollfd> fds;
+	char buffer[4096];
+	while(!stop)
+	{
+		// Busy clients are not read from until answered.
+		fds.clear();
+		fds.push_back({listener, POLLIN, 0});
+		fds.push_back({wake[0], POLLIN, 0});
+		for(auto& client : clients)
+			if(!client.second.busy)
+				fds.push_back({client.first, POLLIN, 0});
+
+		if(poll(fds.data(), fds.size(), 250) <= 0)
+			continue;
+
+		if(fds[0].revents & POLLIN)
+		{
+			int fd;
+			while((fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC)) != -1)
+			{
+				// A client that stops reading its answers loses them.
+				timeval tv{5, 0};
+				setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+				clients[fd];
+			}
+		}
+
+		if(fds[1].revents & POLLIN)
+		{
+			while(read(wake[0], buffer, sizeof(buffer)) > 0)
+				;
+			std::vector<std::pair<int, bool> > done;
+			{
+				std::lock_guard<std::mutex> lock(answered.m);
+				done.swap(answered.clients);
+			}
+			for(auto& d : done)
+			{
+				auto& client = clients[d.first];
+				client.busy = false;
+				if(d.second)
+					dispatch(d.first, client);
+				else
+					disconnect(d.first);
+			}
+		}
+
+		for(std::size_t i = 2; i < fds.size(); ++i)
+		{
+			if(!fds[i].revents)
+				continue;
+
+			// Some may have been answered and handed a new line above.
+			int fd = fds[i].fd;
+			auto it = clients.find(fd);
+			if(it == clients.end() || it->second.busy)
+				continue;
+
+			ssize_t n = read(fd, buffer, sizeof(buffer));
+			if(n == -1 && errno == EINTR)
+				continue;
+			if(n <= 0)
+			{
+				disconnect(fd);
+				continue;
+			}
+			it->second.pending.append(buffer, n);
+			dispatch(fd, it->second);
+		}
+	}
+
+	requests.finish();
+	for(auto& thread : threads)
+		thread.join();
+	for(auto& client : clients)
+		close(client.first);
+	close(wake[0]);
+	close(wake[1]);
+
+	close(listener);
+	unlink(path.c_str());
+	return true;
+}
@@ -0,0 +1,45 @@
+/*
+ * serve.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SERVE_H_
+#define SERVE_H_
+#include <cstddef>
+#include <string>
+
+struct serve_options
+{
+	// unix socket to listen on; src/photo.sock if empty.
+	std::string socket;
+
+	// requests answered at once, each thread on its own db connection.
+	unsigned threads;
+
+	// prepared statements kept per connection.
+	std::size_t cache;
+
+	serve_options();
+};
+
+/*
+ * Answers queries over a unix socket until interrupted.
+ *
+ * A request is one line holding query options as given to photodb query,
+ * separated by spaces, or by tabs if any contains a space. The answer is
+ * "OK n\n" followed by n bytes of what query would print, or "ERR what\n".
+ * A client may send any number of requests on one connection.
+ *
+ * Requests from all clients go to whichever thread is free; an idle client
+ * holds none. Each thread holds a read only connection and the statements
+ * prepared on it, keyed by SQL with the values bound as parameters, so a
+ * query with the same filters is neither opened nor parsed again.
+ *
+ * The db is switched to WAL, so a scan can write while queries are served.
+ * That is kept in the db: later scans use WAL too, leaving photo.db-wal and
+ * photo.db-shm beside it, which scans skip.
+ */
+bool serve_db(const std::string& src, const serve_options& options);
+
+#endif /* SERVE_H_ */
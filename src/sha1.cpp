@@ -115,28 +115,15 @@ namespace sha1
         }
     } // namespace
 
-    void calc(const void* src, const int bytelength, unsigned char* hash)
+    namespace // local
     {
-        // Init the result array.
-        unsigned int result[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
-
-        // Cast the void src pointer to be the byte array we can work with.
-        const unsigned char* sarray = (const unsigned char*) src;
-
-        // The reusable round buffer
-        unsigned int w[80];
-
-        // Loop through all complete 64byte blocks.
-        const int endOfFullBlocks = bytelength - 64;
-        int endCurrentBlock;
-        int currentBlock = 0;
-
-        while (currentBlock <= endOfFullBlocks)
+        void hashBlock(unsigned int* result, const unsigned char* sarray)
         {
-            endCurrentBlock = currentBlock + 64;
+            // The reusable round buffer
+            unsigned int w[80];
 
             // Init the round buffer with the 64 byte block data.
-            for (int roundPos = 0; currentBlock < endCurrentBlock; currentBlock += 4)
+            for (int roundPos = 0, currentBlock = 0; currentBlock < 64; currentBlock += 4)
             {
                 // This line will swap endian on big endian and keep endian on little endian.
                 w[roundPos++] = (unsigned int) sarray[currentBlock + 3]
@@ -146,31 +133,91 @@ namespace sha1
             }
             innerHash(result, w);
         }
+    } // namespace
+
+    void init(context& ctx)
+    {
+        ctx.result[0] = 0x67452301;
+        ctx.result[1] = 0xefcdab89;
+        ctx.result[2] = 0x98badcfe;
+        ctx.result[3] = 0x10325476;
+        ctx.result[4] = 0xc3d2e1f0;
+        ctx.blockBytes = 0;
+        ctx.bytelength = 0;
+    }
 
-        // Handle the last and not full 64 byte block if existing.
-        endCurrentBlock = bytelength - currentBlock;
-        clearWBuffert(w);
-        int lastBlockBytes = 0;
-        for (;lastBlockBytes < endCurrentBlock; ++lastBlockBytes)
+    void update(context& ctx, const void* src, std::size_t bytelength)
+    {
+        const unsigned char* sarray = (const unsigned char*) src;
+        ctx.bytelength += bytelength;
+
+        // Top up a partial block left by the last update.
+        if (ctx.blockBytes)
         {
-            w[lastBlockBytes >> 2] |= (unsigned int) sarray[lastBlockBytes + currentBlock] << ((3 - (lastBlockBytes & 3)) << 3);
+            while (bytelength && ctx.blockBytes < 64)
+            {
+                ctx.block[ctx.blockBytes++] = *sarray++;
+                --bytelength;
+            }
+            if (ctx.blockBytes < 64)
+            {
+                return;
+            }
+            hashBlock(ctx.result, ctx.block);
+            ctx.blockBytes = 0;
         }
-        w[lastBlockBytes >> 2] |= 0x80 << ((3 - (lastBlockBytes & 3)) << 3);
-        if (endCurrentBlock >= 56)
+
+        // Loop through all complete 64byte blocks.
+        for (; bytelength >= 64; sarray += 64, bytelength -= 64)
         {
-            innerHash(result, w);
-            clearWBuffert(w);
+            hashBlock(ctx.result, sarray);
         }
-        w[15] = bytelength << 3;
-        innerHash(result, w);
+
+        for (; bytelength; --bytelength)
+        {
+            ctx.block[ctx.blockBytes++] = *sarray++;
+        }
+    }
+
+    void final(context& ctx, unsigned char* hash)
+    {
+        const unsigned long long bitlength = ctx.bytelength << 3;
+
+        ctx.block[ctx.blockBytes++] = 0x80;
+        if (ctx.blockBytes > 56)
+        {
+            while (ctx.blockBytes < 64)
+            {
+                ctx.block[ctx.blockBytes++] = 0;
+            }
+            hashBlock(ctx.result, ctx.block);
+            ctx.blockBytes = 0;
+        }
+        while (ctx.blockBytes < 56)
+        {
+            ctx.block[ctx.blockBytes++] = 0;
+        }
+        for (int lengthByte = 8; --lengthByte >= 0;)
+        {
+            ctx.block[ctx.blockBytes++] = (bitlength >> (lengthByte << 3)) & 0xff;
+        }
+        hashBlock(ctx.result, ctx.block);
 
         // Store hash in result pointer, and make sure we get in in the correct order on both endian models.
         for (int hashByte = 20; --hashByte >= 0;)
         {
-            hash[hashByte] = (result[hashByte >> 2] >> (((3 - hashByte) & 0x3) << 3)) & 0xff;
+            hash[hashByte] = (ctx.result[hashByte >> 2] >> (((3 - hashByte) & 0x3) << 3)) & 0xff;
         }
     }
 
+    void calc(const void* src, const std::size_t bytelength, unsigned char* hash)
+    {
+        context ctx;
+        init(ctx);
+        update(ctx, src, bytelength);
+        final(ctx, hash);
+    }
+
     void toHexString(const unsigned char* hash, char* hexstring)
     {
         const char hexDigits[] = { "0123456789abcdef" };
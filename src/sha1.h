@@ -28,15 +28,44 @@
 #ifndef SHA1_DEFINED
 #define SHA1_DEFINED
 
+#include <cstddef>
+
 namespace sha1
 {
 
+    /**
+     State for hashing data that arrives in pieces. Feed it with update and finish with final.
+     */
+    struct context
+    {
+        unsigned int result[5];
+        unsigned char block[64];
+        unsigned int blockBytes;
+        unsigned long long bytelength;
+    };
+
+    /**
+     @param ctx is reset to hash a new message.
+     */
+    void init(context& ctx);
+
+    /**
+     @param src points to the next part of the data to be hashed.
+     @param bytelength the number of bytes to hash from the src pointer.
+     */
+    void update(context& ctx, const void* src, std::size_t bytelength);
+
+    /**
+     @param hash should point to a buffer of at least 20 bytes of size for storing the sha1 result in.
+     */
+    void final(context& ctx, unsigned char* hash);
+
     /**
      @param src points to any kind of data to be hashed.
      @param bytelength the number of bytes to hash from the src pointer.
      @param hash should point to a buffer of at least 20 bytes of size for storing the sha1 result in.
      */
-    void calc(const void* src, const int bytelength, unsigned char* hash);
+    void calc(const void* src, const std::size_t bytelength, unsigned char* hash);
 
     /**
      @param hash is 20 bytes of sha1 hash. This is the same data that is the result from the calc function.
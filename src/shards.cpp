@@ -0,0 +1,241 @@
+/*
+ * shards.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "shards.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include "output.h"
+#include "query.h"
+#include "queue.h"
+#include "schema.h"
+
+namespace
+{
+
+const char* const columns = "file_name, path, size, mtime, timestamp, checksum, pixel_size, exif_size, rebuilt, dev, ino, hash, verified, verify_status, thumbnail, thumbnail_size";
+
+struct row_t
+{
+	std::string checksum;
+	std::string hash;
+	int64_t size;
+	std::string file;
+};
+
+typedef std::vector<row_t> batch_t;
+
+const std::size_t batch_rows = 1024;
+
+// filename as a URI that opens it read-only.
+std::string read_only_uri(const std::string& filename)
+{
+	std::string uri = "file:";
+	for(char c : filename)
+	{
+		if(c == '%' || c == '?' || c == '#')
+		{
+			static const char hex[] = "0123456789ABCDEF";
+			uri += '%';
+			uri += hex[static_cast<unsigned char>(c) >> 4];
+			uri += hex[c & 0xf];
+		}
+		else
+			uri += c;
+	}
+	return uri + "?mode=ro";
+}
+
+// The rows of one root in checksum order, read on a thread of its own.
+class shard_t
+{
+private:
+	bounded_queue_t<std::shared_ptr<batch_t>> queue;
+	std::shared_ptr<batch_t> batch;
+	std::size_t next;
+	std::thread reader;
+	bool failed;
+
+	void read(const std::string& root)
+	{
+		try
+		{
+			// Only read: nothing is created or upgraded.
+			db_t db{root + "/photo.db", true};
+			check_schema(db);
+			db_t::statement_t<> select{db, "SELECT checksum, hash, size, path, file_name FROM photos WHERE checksum > '' ORDER BY checksum"};
+
+			auto rows = std::make_shared<batch_t>();
+			bool wanted(true);
+			auto x = [&](const std::tuple<std::string, std::string, int64_t, std::string, std::string>& t)
+			{
+				if(!wanted)
+					return;
+				rows->push_back({std::get<0>(t), std::get<1>(t), std::get<2>(t), std::get<3>(t) + '/' + std::get<4>(t)});
+				if(rows->size() == batch_rows)
+				{
+					wanted = queue.push(rows, 1);
+					rows = std::make_shared<batch_t>();
+				}
+			};
+			select.query<decltype(x), std::string, std::string, int64_t, std::string, std::string>(x);
+			if(!rows->empty())
+				queue.push(rows, 1);
+		}
+		catch(const std::exception& ex)
+		{
+			std::cerr << root << ": " << ex.what() << "\n";
+			failed = true;
+		}
+		queue.finish();
+	}
+public:
+	explicit shard_t(const std::string& root)
+	 : queue(16), next(), failed(false)
+	{
+		reader = std::thread([this, root]{ read(root); });
+	}
+
+	shard_t(const shard_t&) = delete;
+	shard_t& operator=(const shard_t&) = delete;
+
+	// The next row, or nullptr once there are none.
+	const row_t* head()
+	{
+		while(!batch || next == batch->size())
+		{
+			next = 0;
+			if(!queue.pop(batch, true))
+			{
+				batch.reset();
+				return nullptr;
+			}
+		}
+		return &(*batch)[next];
+	}
+
+	void pop()
+	{
+		++next;
+	}
+
+	// Waits for the reader; false if it failed.
+	bool finish()
+	{
+		queue.close();
+		reader.join();
+		return !failed;
+	}
+
+	~shard_t()
+	{
+		if(reader.joinable())
+			finish();
+	}
+};
+
+}
+
+bool attach_shards(db_t& db, const std::vector<std::string>& roots)
+{
+	std::string view = std::string("CREATE TEMP VIEW photos AS SELECT ") + columns + " FROM main.photos";
+	for(std::size_t i = 1; i < roots.size(); ++i)
+	{
+		// Only read: nothing is created or upgraded on the other roots,
+		// which may well be on read-only media.
+		std::string filename = roots[i] + "/photo.db";
+		try
+		{
+			db_t shard{filename, true};
+			check_schema(shard);
+		}
+		catch(const std::runtime_error& ex)
+		{
+			std::cerr << filename << ": " << ex.what() << "\n";
+			return false;
+		}
+
+		std::string name = "shard" + std::to_string(i);
+		db.execute("ATTACH DATABASE " + sql_quote(read_only_uri(filename)) + " AS " + name);
+		view += std::string(" UNION ALL SELECT ") + columns + " FROM " + name + ".photos";
+	}
+	db.execute(view);
+	return true;
+}
+
+bool dups_db(const std::vector<std::string>& roots)
+{
+	std::vector<std::unique_ptr<shard_t>> shards;
+	for(auto& root : roots)
+		shards.emplace_back(new shard_t(root));
+
+	writer_t out(stdout);
+	uint64_t sets(0), copies(0), bytes(0);
+	std::vector<row_t> group;
+	while(true)
+	{
+		// The lowest checksum still to come, and every row that has it.
+		const row_t* lowest = nullptr;
+		for(auto& shard : shards)
+		{
+			auto row = shard->head();
+			if(row && (!lowest || row->checksum < lowest->checksum))
+				lowest = row;
+		}
+		if(!lowest)
+			break;
+
+		std::string checksum = lowest->checksum;
+		group.clear();
+		for(auto& shard : shards)
+		{
+			for(auto row = shard->head(); row && row->checksum == checksum; row = shard->head())
+			{
+				group.push_back(*row);
+				shard->pop();
+			}
+		}
+
+		// The same digest by different algorithms is not the same file.
+		std::stable_sort(begin(group), end(group), [](const row_t& a, const row_t& b)
+		{
+			return a.hash < b.hash;
+		});
+		for(auto first = begin(group); first != end(group); )
+		{
+			auto last = std::find_if(first, end(group), [&first](const row_t& row)
+			{
+				return row.hash != first->hash;
+			});
+			if(last - first > 1)
+			{
+				++sets;
+				for(auto it = first; it != last; ++it)
+				{
+					out.put(it->hash).put(':').put(it->checksum).put('\t');
+					out.put(it->size).put('\t');
+					out.put(it->file).put('\n');
+					if(it != first)
+					{
+						++copies;
+						bytes += it->size;
+					}
+				}
+			}
+			first = last;
+		}
+	}
+	out.flush();
+
+	bool ok(true);
+	for(auto& shard : shards)
+		ok = shard->finish() && ok;
+
+	std::cerr << sets << " Sets of duplicates; " << copies << " copies of " << (bytes >> 20) << " MB.\n";
+	return ok;
+}
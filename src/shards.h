@@ -0,0 +1,30 @@
+/*
+ * shards.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SHARDS_H_
+#define SHARDS_H_
+#include <string>
+#include <vector>
+#include "db.h"
+
+/*
+ * Attaches the photo.db of each further root to db and puts a temporary
+ * photos view over all of them in front of its own photos table, so that
+ * queries and exports read every root at once. The further roots are
+ * attached read-only and must already have the current schema. SQLite
+ * allows ten attached databases unless built otherwise. False, with the
+ * reason on stderr, if one cannot be read.
+ */
+bool attach_shards(db_t& db, const std::vector<std::string>& roots);
+
+/*
+ * Lists the files with the same checksum across all the roots. Each root's
+ * db is read in checksum order on its own thread and the rows merged as they
+ * arrive, so every disk is read at once and little is held in memory.
+ */
+bool dups_db(const std::vector<std::string>& roots);
+
+#endif /* SHARDS_H_ */
@@ -0,0 +1,338 @@
+/*
+ * snapshot.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "snapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "output.h"
+#include "timestamp.h"
+#include "util.h"
+#include <unistd.h>
+
+const uint32_t snapshot_t::version;
+const int64_t snapshot_t::unknown;
+
+namespace
+{
+
+typedef db_t::text_t text_t;
+typedef std::unique_ptr<FILE, int(*)(FILE*)> file_t;
+
+const char magic[8] = {'p', 'h', 'o', 't', 'o', 's', 'n', 'p'};
+
+const std::size_t widths[snapshot_t::column_count] = {8, 8, 8, 4, 4, 4, 4, sizeof(snapshot_t::digest_t), 4, 4, 4};
+
+uint64_t align(uint64_t n)
+{
+	return (n + 63) & ~uint64_t(63);
+}
+
+// Year * 12 + month - 1 of a day since 1970-01-01.
+int64_t month_from_days(int64_t z)
+{
+	z += 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(z - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+	const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+	return (static_cast<int64_t>(yoe) + era * 400 + (m <= 2)) * 12 + m - 1;
+}
+
+// A time as seconds; see timestamp_seconds().
+int64_t seconds(const text_t& t)
+{
+	return timestamp_seconds(t.data, t.size);
+}
+
+// Parses width,height; zeros if not set.
+void dimensions(const text_t& t, uint32_t& width, uint32_t& height)
+{
+	char* end;
+	width = strtoul(t.data, &end, 10);
+	height = *end == ',' ? strtoul(end + 1, nullptr, 10) : 0;
+}
+
+snapshot_t::digest_t digest(const text_t& t)
+{
+	snapshot_t::digest_t d;
+	memset(&d, 0, sizeof(d));
+	for(std::size_t i = 0; i + 1 < t.size && i / 2 < sizeof(d.bytes); i += 2)
+	{
+		auto nibble = [](char c)
+		{
+			return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+		};
+		d.bytes[i / 2] = nibble(t.data[i]) << 4 | nibble(t.data[i + 1]);
+	}
+	return d;
+}
+
+// Appends strings to the heap, storing each distinct interned one once.
+class heap_t
+{
+private:
+	writer_t& out;
+	uint64_t size;
+	std::unordered_map<std::string, uint32_t> interned;
+public:
+	explicit heap_t(writer_t& out)
+	 : out(out), size()
+	{
+	}
+
+	uint32_t add(const text_t& s)
+	{
+		throw_if(size + s.size + 1 > UINT32_MAX, "snapshot string heap exceeds 4GB");
+		uint32_t offset = size;
+		out.put(s.data, s.size).put('\0');
+		size += s.size + 1;
+		return offset;
+	}
+	uint32_t intern(const text_t& s)
+	{
+		std::string key(s.data, s.size);
+		auto it = interned.find(key);
+		if(it != interned.end())
+			return it->second;
+		return interned[key] = add(s);
+	}
+
+	uint64_t length() const
+	{
+		return size;
+	}
+};
+
+template <typename T>
+void put(writer_t& out, const T& value)
+{
+	out.put(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}
+
+snapshot_t::snapshot_t(const std::string& filename)
+ : map(filename.c_str(), mmap_t::willneed), header(static_cast<const header_t*>(static_cast<void*>(map))), base(static_cast<const char*>(static_cast<void*>(map)))
+{
+	throw_if(map.length() < sizeof(header_t) || memcmp(header->magic, magic, sizeof(magic)) != 0, filename + ": not a snapshot");
+	throw_if(header->version != version || header->columns != column_count, filename + ": snapshot version " + std::to_string(header->version) + " is not supported");
+
+	for(int c = 0; c < column_count; ++c)
+		throw_if(header->offset[c] % 64 || header->offset[c] + header->rows * widths[c] > map.length(), filename + ": truncated snapshot");
+	throw_if(header->heap + header->heap_size > map.length() || (header->heap_size && base[header->heap + header->heap_size - 1]), filename + ": truncated snapshot");
+}
+
+uint64_t snapshot_t::rows() const
+{
+	return header->rows;
+}
+
+const char* snapshot_t::string(uint32_t offset) const
+{
+	return base + header->heap + offset;
+}
+
+std::string snapshot_file(const std::string& src)
+{
+	return src + "/photo.snap";
+}
+
+bool snapshot_db(db_t& db, const std::string& src)
+{
+	const std::string filename = snapshot_file(src);
+	const std::string tmp = filename + ".tmp";
+
+	db_t::statement_t<> count_photos{db, "SELECT count(*) FROM photos"};
+	db_t::statement_t<> select_photos{db, "SELECT size, mtime, timestamp, pixel_size, exif_size, checksum, hash, path, file_name FROM photos ORDER BY checksum"};
+
+	db.execute("BEGIN");
+
+	snapshot_t::header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = snapshot_t::version;
+	header.columns = snapshot_t::column_count;
+
+	auto x = [&header](const std::tuple<int64_t>& t)
+	{
+		header.rows = std::get<0>(t);
+	};
+	count_photos.query<decltype(x), int64_t>(x);
+
+	uint64_t offset = align(sizeof(header));
+	for(int c = 0; c < snapshot_t::column_count; ++c)
+	{
+		header.offset[c] = offset;
+		offset = align(offset + header.rows * widths[c]);
+	}
+	header.heap = offset;
+
+	// A stream per column, each positioned at the start of its array, and
+	// one more for the heap, so the rows are written as they come.
+	std::vector<file_t> files;
+	std::vector<std::unique_ptr<writer_t>> out;
+	for(int c = 0; c <= snapshot_t::column_count; ++c)
+	{
+		files.emplace_back(fopen(tmp.c_str(), c ? "r+" : "w+"), fclose);
+		throw_if(!files.back(), tmp + ": " + strerror(errno));
+		throw_if(fseek(files.back().get(), c < snapshot_t::column_count ? header.offset[c] : header.heap, SEEK_SET) != 0, tmp + ": " + strerror(errno));
+		out.emplace_back(new writer_t(files.back().get(), 256 << 10));
+	}
+	heap_t heap(*out[snapshot_t::column_count]);
+
+	uint64_t rows(0);
+	auto y = [&](const std::tuple<int64_t, text_t, text_t, text_t, text_t, text_t, text_t, text_t, text_t>& t)
+	{
+		uint32_t width, height;
+
+		put(*out[snapshot_t::size], static_cast<uint64_t>(std::get<0>(t)));
+		put(*out[snapshot_t::mtime], seconds(std::get<1>(t)));
+		put(*out[snapshot_t::timestamp], seconds(std::get<2>(t)));
+		dimensions(std::get<3>(t), width, height);
+		put(*out[snapshot_t::pixel_width], width);
+		put(*out[snapshot_t::pixel_height], height);
+		dimensions(std::get<4>(t), width, height);
+		put(*out[snapshot_t::exif_width], width);
+		put(*out[snapshot_t::exif_height], height);
+		put(*out[snapshot_t::checksum], digest(std::get<5>(t)));
+		put(*out[snapshot_t::hash], heap.intern(std::get<6>(t)));
+		put(*out[snapshot_t::path], heap.intern(std::get<7>(t)));
+		put(*out[snapshot_t::file_name], heap.add(std::get<8>(t)));
+		++rows;
+	};
+	select_photos.query<decltype(y), int64_t, text_t, text_t, text_t, text_t, text_t, text_t, text_t, text_t>(y);
+
+	db.execute("COMMIT");
+	throw_if(rows != header.rows, "photos changed while writing the snapshot");
+	header.heap_size = heap.length();
+
+	for(auto& o : out)
+		o->flush();
+	out.clear();
+
+	FILE* f = files[0].get();
+	throw_if(fseek(f, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, f) != 1, tmp + ": " + strerror(errno));
+	// The heap ends the file, even when it is empty.
+	throw_if(ftruncate(fileno(f), header.heap + header.heap_size) != 0, tmp + ": " + strerror(errno));
+	for(auto& file : files)
+		throw_if(fclose(file.release()) != 0, tmp + ": " + strerror(errno));
+
+	throw_if(rename(tmp.c_str(), filename.c_str()) != 0, filename + ": " + strerror(errno));
+	return true;
+}
+
+bool stats_db(const std::string& src)
+{
+	snapshot_t snapshot(snapshot_file(src));
+	const uint64_t n = snapshot.rows();
+	const uint64_t* sizes = snapshot.sizes();
+	const int64_t* timestamps = snapshot.timestamps();
+	const snapshot_t::digest_t* checksums = snapshot.checksums();
+	const uint32_t* hashes = snapshot.strings(snapshot_t::hash);
+
+	uint64_t bytes(0);
+	int64_t first(INT64_MAX), last(INT64_MIN + 1);
+	for(uint64_t i = 0; i < n; ++i)
+	{
+		bytes += sizes[i];
+		if(timestamps[i] != snapshot_t::unknown)
+		{
+			first = std::min(first, timestamps[i]);
+			last = std::max(last, timestamps[i]);
+		}
+	}
+
+	// Months are counted by day, so each distinct day is converted once.
+	struct tally_t
+	{
+		uint64_t photos;
+		uint64_t bytes;
+	};
+	const int64_t first_day = first <= last ? (first >= 0 ? first : first - 86399) / 86400 : 0;
+	const int64_t last_day = first <= last ? (last >= 0 ? last : last - 86399) / 86400 : -1;
+	std::vector<tally_t> days(last_day - first_day + 1, tally_t());
+	tally_t undated = tally_t();
+	tally_t size_buckets[64] = {};
+	for(uint64_t i = 0; i < n; ++i)
+	{
+		const int64_t t = timestamps[i];
+		tally_t& day = t == snapshot_t::unknown ? undated : days[(t >= 0 ? t : t - 86399) / 86400 - first_day];
+		++day.photos;
+		day.bytes += sizes[i];
+
+		tally_t& bucket = size_buckets[63 - __builtin_clzll(sizes[i] | 1)];
+		++bucket.photos;
+		bucket.bytes += sizes[i];
+	}
+
+	// Copies sort together; the first of each set is the original.
+	tally_t copies = tally_t();
+	uint64_t sets(0);
+	bool in_set(false);
+	static const snapshot_t::digest_t none = snapshot_t::digest_t();
+	for(uint64_t i = 1; i < n; ++i)
+	{
+		bool copy = hashes[i] == hashes[i - 1] && memcmp(&checksums[i], &checksums[i - 1], sizeof(none)) == 0 && memcmp(&checksums[i], &none, sizeof(none)) != 0;
+		if(copy)
+		{
+			sets += !in_set;
+			++copies.photos;
+			copies.bytes += sizes[i];
+		}
+		in_set = copy;
+	}
+
+	writer_t out(stdout);
+	auto line = [&out](const char* name, const std::string& key, const tally_t& tally)
+	{
+		out.put(name).put('\t');
+		if(!key.empty())
+			out.put(key).put('\t');
+		out.put(static_cast<int64_t>(tally.photos)).put('\t').put(static_cast<int64_t>(tally.bytes)).put('\n');
+	};
+
+	line("total", "", tally_t{n, bytes});
+	tally_t month = tally_t();
+	int64_t current = days.empty() ? 0 : month_from_days(first_day);
+	for(std::size_t d = 0; d <= days.size(); ++d)
+	{
+		int64_t m = d < days.size() ? month_from_days(first_day + d) : current + 1;
+		if(m != current)
+		{
+			if(month.photos)
+			{
+				char key[48];
+				snprintf(key, sizeof(key), "%04lld-%02lld", static_cast<long long>(current / 12), static_cast<long long>(current % 12 + 1));
+				line("month", key, month);
+			}
+			month = tally_t();
+			current = m;
+		}
+		if(d < days.size())
+		{
+			month.photos += days[d].photos;
+			month.bytes += days[d].bytes;
+		}
+	}
+	if(undated.photos)
+		line("month", "unknown", undated);
+
+	for(int b = 0; b < 64; ++b)
+		if(size_buckets[b].photos)
+			line("size", std::to_string(b ? uint64_t(1) << b : 0), size_buckets[b]);
+
+	line("duplicates", std::to_string(sets), copies);
+	return true;
+}
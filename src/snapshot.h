@@ -0,0 +1,106 @@
+/*
+ * snapshot.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "db.h"
+#include "mmap.h"
+
+/*
+ * A read-only copy of the photos table laid out by column, for aggregates
+ * that would otherwise walk the db row by row.
+ *
+ * The file is a header followed by one fixed width array per column, each
+ * starting on a 64 byte boundary, then a heap of nul terminated strings that
+ * the path, file_name and hash columns index. Everything is in host byte
+ * order. Rows are ordered by checksum, so copies of a file are adjacent.
+ * Times are seconds since 1970 of the recorded local time, or unknown.
+ */
+class snapshot_t
+{
+public:
+	enum column_t
+	{
+		size,			// uint64_t
+		mtime,			// int64_t
+		timestamp,		// int64_t
+		pixel_width,	// uint32_t
+		pixel_height,
+		exif_width,
+		exif_height,
+		checksum,		// digest_t
+		hash,			// uint32_t heap offsets
+		path,
+		file_name,
+		column_count
+	};
+
+	// The binary checksum, zero padded.
+	struct digest_t
+	{
+		uint8_t bytes[32];
+	};
+
+	static const uint32_t version = 1;
+	static const int64_t unknown = INT64_MIN;
+
+	struct header_t
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t columns;
+		uint64_t rows;
+		uint64_t offset[column_count];
+		uint64_t heap;
+		uint64_t heap_size;
+	};
+private:
+	mmap_t map;
+	const header_t* header;
+	const char* base;
+
+	template <typename T>
+	const T* column(column_t c) const
+	{
+		return reinterpret_cast<const T*>(base + header->offset[c]);
+	}
+public:
+	// Maps the file; throws std::runtime_error if it is not a snapshot of
+	// this version.
+	explicit snapshot_t(const std::string& filename);
+
+	uint64_t rows() const;
+
+	const uint64_t* sizes() const { return column<uint64_t>(size); }
+	const int64_t* mtimes() const { return column<int64_t>(mtime); }
+	const int64_t* timestamps() const { return column<int64_t>(timestamp); }
+	const uint32_t* dimensions(column_t c) const { return column<uint32_t>(c); }
+	const digest_t* checksums() const { return column<digest_t>(checksum); }
+	const uint32_t* strings(column_t c) const { return column<uint32_t>(c); }
+
+	// The string at a heap offset.
+	const char* string(uint32_t offset) const;
+};
+
+// Where the snapshot of src lives.
+std::string snapshot_file(const std::string& src);
+
+/*
+ * Writes the photos table to the snapshot file in one read transaction,
+ * replacing the previous snapshot only once the new one is complete.
+ */
+bool snapshot_db(db_t& db, const std::string& src);
+
+/*
+ * Prints totals, photos and bytes per month, a histogram of file sizes and
+ * the duplicates from the snapshot, without opening the db.
+ */
+bool stats_db(const std::string& src);
+
+#endif /* SNAPSHOT_H_ */
@@ -0,0 +1,93 @@
+/*
+ * thumbs.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "thumbs.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include "util.h"
+
+namespace
+{
+
+const char magic[8] = {'p', 'h', 'o', 't', 'o', 't', 'h', 'm'};
+
+}
+
+thumbnails_t::thumbnails_t(const std::string& filename, bool writable)
+ : fd(filename.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY), end()
+{
+	char header[sizeof(magic)];
+	ssize_t n = pread(fd, header, sizeof(header), 0);
+	throw_if(n == -1, filename + ": " + strerror(errno));
+
+	if(n == 0 && writable)
+	{
+		throw_if(pwrite(fd, magic, sizeof(magic), 0) != sizeof(magic), filename + ": " + strerror(errno));
+		n = sizeof(magic);
+		memcpy(header, magic, sizeof(magic));
+	}
+	throw_if(n != sizeof(magic) || memcmp(header, magic, sizeof(magic)) != 0, filename + ": not a thumbnail file");
+
+	off_t size = lseek(fd, 0, SEEK_END);
+	throw_if(size == -1, filename + ": " + strerror(errno));
+	end = size;
+}
+
+uint64_t thumbnails_t::append(const std::string& data)
+{
+	// A failed write leaves end where it was, so the next one overwrites it.
+	for(std::size_t done = 0; done < data.size(); )
+	{
+		ssize_t n = pwrite(fd, data.data() + done, data.size() - done, end + done);
+		throw_if(n <= 0, std::string("thumbnails: ") + strerror(errno));
+		done += n;
+	}
+
+	uint64_t offset = end;
+	end += data.size();
+	return offset;
+}
+
+std::string thumbnails_t::read(uint64_t offset, uint64_t size) const
+{
+	std::string data(size, '\0');
+	ssize_t n = pread(fd, &data[0], size, offset);
+	throw_if(n == -1, std::string("thumbnails: ") + strerror(errno));
+	throw_if(static_cast<uint64_t>(n) != size, "thumbnails: truncated");
+	return data;
+}
+
+std::string thumbnails_file(const std::string& src)
+{
+	return src + "/photo.thumbs";
+}
+
+bool thumbnail_db(db_t& db, const std::string& src, int64_t id)
+{
+	db_t::statement_t<int64_t> select_thumbnail{db, "SELECT thumbnail, thumbnail_size FROM photos WHERE ROWID = ?"};
+
+	int64_t offset(0), size(0);
+	auto x = [&offset, &size](const std::tuple<int64_t, int64_t>& t)
+	{
+		std::tie(offset, size) = t;
+	};
+	select_thumbnail.query<decltype(x), int64_t, int64_t>(x, id);
+
+	if(!size)
+	{
+		std::cerr << "photo " << id << " has no thumbnail\n";
+		return false;
+	}
+
+	thumbnails_t thumbnails(thumbnails_file(src), false);
+	auto data = thumbnails.read(offset, size);
+	return fwrite(data.data(), data.size(), 1, stdout) == 1;
+}
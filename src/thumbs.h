@@ -0,0 +1,41 @@
+/*
+ * thumbs.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef THUMBS_H_
+#define THUMBS_H_
+#include <cstdint>
+#include <string>
+#include "db.h"
+#include "mmap.h"
+
+/*
+ * The embedded previews of the photos, one after another in a single file
+ * behind a short header. Each row records where its preview starts and how
+ * long it is (thumbnail and thumbnail_size), so serving one is a single
+ * pread(), or a slice of the mapped file, with nothing decoded.
+ * The file is only appended to; previews of rows since removed stay in it.
+ */
+class thumbnails_t
+{
+private:
+	fd_t fd;
+	uint64_t end;
+public:
+	// Opens the file, creating it when writable.
+	thumbnails_t(const std::string& filename, bool writable);
+
+	// Writes a preview at the end; its offset.
+	uint64_t append(const std::string& data);
+	std::string read(uint64_t offset, uint64_t size) const;
+};
+
+// Where the previews of src are kept.
+std::string thumbnails_file(const std::string& src);
+
+// Writes the preview of photo id to stdout; false if it has none.
+bool thumbnail_db(db_t& db, const std::string& src, int64_t id);
+
+#endif /* THUMBS_H_ */
@@ -55,6 +55,40 @@ bool timestamp_t::operator<(const timestamp_t& o) const
 	return std::tie(year, month, day, hour, minute, second) < std::tie(o.year, o.month, o.day, o.hour, o.minute, o.second);
 }
 
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(y - era * 400);
+	const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+int64_t timestamp_seconds(const char* s, std::size_t n)
+{
+	static const int fields[][2] = {{0, 4}, {5, 2}, {8, 2}, {11, 2}, {14, 2}, {17, 2}};
+	if(n < 19)
+		return INT64_MIN;
+
+	int64_t v[6];
+	for(int f = 0; f < 6; ++f)
+	{
+		v[f] = 0;
+		for(int i = fields[f][0]; i < fields[f][0] + fields[f][1]; ++i)
+		{
+			unsigned digit = s[i] - '0';
+			if(digit > 9)
+				return INT64_MIN;
+			v[f] = v[f] * 10 + digit;
+		}
+	}
+	// Cameras with no clock write zeros.
+	if(!v[0])
+		return INT64_MIN;
+	return days_from_civil(v[0], v[1], v[2]) * 86400 + v[3] * 3600 + v[4] * 60 + v[5];
+}
+
 std::ostream& operator<<(std::ostream& os, const timestamp_t& ts)
 {
 	return os << std::setw(4) << std::setfill('0') << ts.year << '-'
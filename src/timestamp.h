@@ -7,6 +7,8 @@
 
 #ifndef TIMESTAMP_H_
 #define TIMESTAMP_H_
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 #include <ostream>
 #include <string>
@@ -30,4 +32,15 @@ struct timestamp_t
 
 std::ostream& operator<<(std::ostream& os, const timestamp_t& ts);
 
+// Days since 1970-01-01 of a civil date.
+int64_t days_from_civil(int64_t year, unsigned month, unsigned day);
+
+/*
+ * Seconds since 1970 of a recorded time, yyyy-mm-dd hh:mm:ss (or with colons
+ * in the date, as exif has it), taken as UTC so that differences are exact.
+ * Much cheaper than timestamp_t for a column of them. INT64_MIN for an empty
+ * or zero time, or anything else.
+ */
+int64_t timestamp_seconds(const char* s, std::size_t n);
+
 #endif /* TIMESTAMP_H_ */
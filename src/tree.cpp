@@ -0,0 +1,92 @@
+/*
+ * tree.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "tree.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "hash.h"
+#include "mmap.h"
+
+uint64_t tree_hash(const std::string& filename, uint64_t size, const read_options& options, std::string& root, std::vector<std::string>& chunks)
+{
+	fd_t fd(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	const uint64_t chunk = options.chunk;
+	const size_t count = std::max<uint64_t>((size + chunk - 1) / chunk, 1);
+	chunks.assign(count, {});
+	std::vector<uint64_t> read(count);
+
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	int error(0);
+
+	auto worker = [&]
+	{
+		std::vector<char> buffer(options.buffer);
+		for(size_t i; !failed && (i = next++) < count; )
+		{
+			auto hasher = hasher_t::create(options.hash);
+			uint64_t offset = i * chunk;
+			uint64_t end = std::min(offset + chunk, size);
+			while(offset < end)
+			{
+				ssize_t n = pread(fd, buffer.data(), std::min<uint64_t>(buffer.size(), end - offset), offset);
+				if(n == -1 && errno == EINTR)
+					continue;
+				if(n == -1)
+				{
+					if(!failed.exchange(true))
+						error = errno;
+					return;
+				}
+				if(n == 0)
+					break;
+				hasher->update(buffer.data(), n);
+				offset += n;
+				read[i] += n;
+			}
+			chunks[i] = hasher->final();
+
+			// Only the mapped mode means to leave the file cached.
+			if(options.mode != read_options::map)
+				posix_fadvise(fd, i * chunk, read[i], POSIX_FADV_DONTNEED);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(unsigned i = 1; i < std::max(options.threads, 1u); ++i)
+		workers.emplace_back(worker);
+	worker();
+	for(auto& w : workers)
+		w.join();
+
+	if(failed)
+		throw std::runtime_error(strerror(error));
+
+	auto hasher = hasher_t::create(options.hash);
+	uint64_t bytes(0);
+	for(size_t i = 0; i < count; ++i)
+	{
+		hasher->update(chunks[i].data(), chunks[i].size());
+		bytes += read[i];
+	}
+	root = hasher->final();
+	return bytes;
+}
+
+std::string tree_hash_name(const read_options& options)
+{
+	return "tree-" + std::to_string(options.chunk >> 20) + "M:" + hash_name(options.hash);
+}
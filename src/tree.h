@@ -0,0 +1,26 @@
+/*
+ * tree.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef TREE_H_
+#define TREE_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "reader.h"
+
+/*
+ * Hashes a file as options.chunk sized pieces on options.threads threads.
+ * The checksum is the hash of the chunk digests in order, so one large file
+ * keeps every core busy and any chunk can later be checked on its own.
+ * Returns the bytes read, short of size if the file was truncated.
+ * Throws std::runtime_error if the file cannot be read.
+ */
+uint64_t tree_hash(const std::string& filename, uint64_t size, const read_options& options, std::string& root, std::vector<std::string>& chunks);
+
+// The hash name recorded for tree checksums, e.g. tree-16M:sha1.
+std::string tree_hash_name(const read_options& options);
+
+#endif /* TREE_H_ */
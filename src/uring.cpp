@@ -0,0 +1,151 @@
+/*
+ * uring.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "uring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util.h"
+
+namespace
+{
+
+int io_uring_setup(unsigned entries, io_uring_params* p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+template <typename T>
+T* at(void* base, unsigned offset)
+{
+	return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}
+
+uring_t::uring_t(unsigned entries)
+ : fd(-1), sq_ring(MAP_FAILED), sq_ring_size(), cq_ring(MAP_FAILED), cq_ring_size(), sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqes_size(), queued()
+{
+	memset(&params, 0, sizeof(params));
+	fd = io_uring_setup(entries, &params);
+	throw_if(fd == -1, std::string("io_uring_setup: ") + strerror(errno));
+
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if(params.features & IORING_FEAT_SINGLE_MMAP)
+		sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+	sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if(sq_ring == MAP_FAILED)
+	{
+		close(fd);
+		throw std::runtime_error(strerror(errno));
+	}
+
+	if(params.features & IORING_FEAT_SINGLE_MMAP)
+		cq_ring = sq_ring;
+	else
+		cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+	sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	if(cq_ring != MAP_FAILED)
+		sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+	if(cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+	{
+		int err = errno;
+		if(cq_ring != MAP_FAILED && cq_ring != sq_ring)
+			munmap(cq_ring, cq_ring_size);
+		munmap(sq_ring, sq_ring_size);
+		close(fd);
+		throw std::runtime_error(strerror(err));
+	}
+
+	sq_head = at<unsigned>(sq_ring, params.sq_off.head);
+	sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+	sq_mask = at<unsigned>(sq_ring, params.sq_off.ring_mask);
+	sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+	cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+	cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+	cq_mask = at<unsigned>(cq_ring, params.cq_off.ring_mask);
+	cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+}
+
+io_uring_sqe* uring_t::sqe()
+{
+	unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+	unsigned tail = *sq_tail + queued;
+	if(tail - head >= params.sq_entries)
+		return nullptr;
+
+	unsigned index = tail & *sq_mask;
+	io_uring_sqe* e = &sqes[index];
+	memset(e, 0, sizeof(*e));
+	sq_array[index] = index;
+	++queued;
+	return e;
+}
+
+void uring_t::submit(unsigned wait)
+{
+	__atomic_store_n(sq_tail, *sq_tail + queued, __ATOMIC_RELEASE);
+
+	unsigned to_submit = queued;
+	queued = 0;
+	while(true)
+	{
+		int res = io_uring_enter(fd, to_submit, wait, wait ? IORING_ENTER_GETEVENTS : 0);
+		if(res >= 0)
+			break;
+		throw_if(errno != EINTR, std::string("io_uring_enter: ") + strerror(errno));
+		to_submit = 0;
+	}
+}
+
+void uring_t::register_buffers(const iovec* iovs, unsigned count)
+{
+	throw_if(io_uring_register(fd, IORING_REGISTER_BUFFERS, iovs, count) != 0, std::string("IORING_REGISTER_BUFFERS: ") + strerror(errno));
+}
+
+void uring_t::register_files(unsigned count)
+{
+	std::vector<int> files(count, -1);
+	throw_if(io_uring_register(fd, IORING_REGISTER_FILES, files.data(), count) != 0, std::string("IORING_REGISTER_FILES: ") + strerror(errno));
+}
+
+void uring_t::update_file(unsigned index, int file)
+{
+	io_uring_files_update update;
+	memset(&update, 0, sizeof(update));
+	update.offset = index;
+	update.fds = reinterpret_cast<uintptr_t>(&file);
+	throw_if(io_uring_register(fd, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1, std::string("IORING_REGISTER_FILES_UPDATE: ") + strerror(errno));
+}
+
+uring_t::~uring_t()
+{
+	munmap(sqes, sqes_size);
+	if(cq_ring != sq_ring)
+		munmap(cq_ring, cq_ring_size);
+	munmap(sq_ring, sq_ring_size);
+	close(fd);
+}
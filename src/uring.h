@@ -0,0 +1,71 @@
+/*
+ * uring.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef URING_H_
+#define URING_H_
+#include <cstddef>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+/*
+ * Minimal io_uring over the raw system calls.
+ * One thread submits and reaps; nothing here is thread safe.
+ */
+class uring_t
+{
+private:
+	int fd;
+	io_uring_params params;
+
+	void* sq_ring;
+	std::size_t sq_ring_size;
+	void* cq_ring;
+	std::size_t cq_ring_size;
+	io_uring_sqe* sqes;
+	std::size_t sqes_size;
+
+	unsigned* sq_head;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	io_uring_cqe* cqes;
+
+	unsigned queued;
+public:
+	// Throws std::runtime_error if the kernel has no io_uring.
+	explicit uring_t(unsigned entries);
+
+	uring_t(const uring_t&) = delete;
+	uring_t& operator=(const uring_t&) = delete;
+
+	// Next free submission entry, cleared; nullptr if the queue is full.
+	io_uring_sqe* sqe();
+
+	// Submits queued entries and waits for at least wait completions.
+	void submit(unsigned wait);
+
+	// Calls func(const io_uring_cqe&) for each completion ready.
+	template <typename Fn>
+	void completions(Fn func)
+	{
+		unsigned head = *cq_head;
+		for(unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE); head != tail; ++head)
+			func(cqes[head & *cq_mask]);
+		__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+	}
+
+	void register_buffers(const iovec* iovs, unsigned count);
+	// Registers count empty file slots.
+	void register_files(unsigned count);
+	void update_file(unsigned index, int file);
+
+	~uring_t();
+};
+
+#endif /* URING_H_ */
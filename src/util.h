@@ -7,7 +7,12 @@
 
 #ifndef UTIL_H_
 #define UTIL_H_
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 
 template <typename ex = std::runtime_error>
 void throw_if(bool cond, const std::string& what)
@@ -16,4 +21,34 @@ void throw_if(bool cond, const std::string& what)
 		throw ex(what);
 }
 
+inline void strtonum(const char* s, long long& n, char** end)
+{
+	n = strtoll(s, end, 10);
+}
+
+inline void strtonum(const char* s, unsigned long long& n, char** end)
+{
+	n = strtoull(s, end, 10);
+}
+
+/*
+ * Decimal digits in value, all of them, as n; false (n unchanged) for
+ * anything else, a sign on an unsigned n, or a number too big for it.
+ */
+template <typename T>
+bool parse_number(const std::string& value, T& n)
+{
+	if(value.empty() || (!std::is_signed<T>::value && value[0] == '-'))
+		return false;
+
+	typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type v;
+	char* end;
+	errno = 0;
+	strtonum(value.c_str(), v, &end);
+	if(errno || *end || v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+		return false;
+	n = v;
+	return true;
+}
+
 #endif /* UTIL_H_ */
@@ -0,0 +1,309 @@
+/*
+ * verify.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "verify.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "mmap.h"
+#include "photo.h"
+#include "timestamp.h"
+
+namespace
+{
+
+volatile sig_atomic_t stop(false);
+
+void on_signal(int)
+{
+	stop = true;
+}
+
+// From linux/ioprio.h.
+const int ioprio_who_process = 1;
+const int ioprio_class_idle = 3;
+const int ioprio_class_shift = 13;
+
+void go_idle()
+{
+	if(syscall(SYS_ioprio_set, ioprio_who_process, 0, ioprio_class_idle << ioprio_class_shift) == -1)
+		std::cerr << "ioprio_set: " << strerror(errno) << "\n";
+
+	sched_param param;
+	memset(&param, 0, sizeof(param));
+	if(sched_setscheduler(0, SCHED_IDLE, &param) == -1)
+		std::cerr << "sched_setscheduler: " << strerror(errno) << "\n";
+}
+
+/*
+ * Token buckets for bytes and reads. Up to a second's worth builds up while
+ * idle; beyond that take() sleeps off the debt.
+ */
+class throttle_t
+{
+private:
+	typedef std::chrono::steady_clock clock_type;
+
+	double rate;
+	double iops;
+	double bytes;
+	double reads;
+	clock_type::time_point last;
+public:
+	throttle_t(uint64_t rate, unsigned iops)
+	 : rate(rate), iops(iops), bytes(0), reads(0), last(clock_type::now())
+	{
+	}
+
+	void take(uint64_t n)
+	{
+		auto now = clock_type::now();
+		double elapsed = std::chrono::duration<double>(now - last).count();
+		last = now;
+
+		bytes = std::min(bytes + elapsed * rate, rate) - n;
+		reads = std::min(reads + elapsed * iops, iops) - 1;
+
+		double wait(0);
+		if(rate && bytes < 0)
+			wait = std::max(wait, -bytes / rate);
+		if(iops && reads < 0)
+			wait = std::max(wait, -reads / iops);
+		if(wait > 0)
+			std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+	}
+};
+
+struct chunk_t
+{
+	uint64_t offset;
+	uint64_t length;
+	std::string digest;
+};
+
+// Splits tree-16M:sha1 into its chunk size and algorithm.
+bool parse_hash_name(const std::string& name, hasher_t::algorithm_t& algorithm, uint64_t& chunk)
+{
+	chunk = 0;
+	if(name.compare(0, 5, "tree-") != 0)
+		return parse_hash(name, algorithm);
+
+	auto colon = name.find(':');
+	if(colon == std::string::npos)
+		return false;
+	chunk = std::strtoull(name.c_str() + 5, nullptr, 10) << 20;
+	return chunk && parse_hash(name.substr(colon + 1), algorithm);
+}
+
+/*
+ * Hashes [offset, offset + length) (to the end of the file for a flat
+ * hash) from disk; false on a read error.
+ */
+bool hash_range(int fd, uint64_t offset, uint64_t length, hasher_t& hasher, std::vector<char>& buffer, throttle_t& throttle, uint64_t& read)
+{
+	uint64_t end = offset + length;
+	while(offset < end && !stop)
+	{
+		throttle.take(std::min<uint64_t>(buffer.size(), end - offset));
+		ssize_t n = pread(fd, buffer.data(), std::min<uint64_t>(buffer.size(), end - offset), offset);
+		if(n == -1 && errno == EINTR)
+			continue;
+		if(n == -1)
+			return false;
+		if(n == 0)
+			break;
+		posix_fadvise(fd, offset, n, POSIX_FADV_DONTNEED);
+		hasher.update(buffer.data(), n);
+		offset += n;
+		read += n;
+	}
+	return true;
+}
+
+}
+
+verify_options::verify_options()
+ : rate(0), iops(0), limit(0), idle(false), continuous(false), buffer(1 << 20)
+{
+}
+
+bool verify_db(db_t& db, const verify_options& options)
+{
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, nullptr);
+	sigaction(SIGTERM, &sa, nullptr);
+
+	if(options.idle)
+		go_idle();
+
+	// NULL, never verified, sorts first. Rows whose hashing failed have
+	// nothing to check against; they are only counted.
+	db_t::statement_t<std::string, int> select_oldest{db, "SELECT ROWID, file_name, path, size, mtime, checksum, hash FROM photos WHERE checksum > '' AND hash IS NOT NULL AND (verified IS NULL OR verified < ?) ORDER BY verified, ROWID LIMIT ?"};
+	db_t::statement_t<> count_unhashed{db, "SELECT count(*) FROM photos WHERE NOT (checksum > '' AND hash IS NOT NULL)"};
+	db_t::statement_t<std::string, std::string> select_chunks{db, "SELECT offset, length, chunk FROM chunks WHERE hash = ? AND checksum = ? ORDER BY idx"};
+	db_t::statement_t<std::string, std::string, int64_t> update_verified{db, "UPDATE photos SET verified = ?, verify_status = ? WHERE ROWID = ?"};
+
+	throttle_t throttle(options.rate, options.iops);
+	std::vector<char> buffer(options.buffer);
+
+	// Once through what was last verified before now, unless continuous.
+	const std::string before = options.continuous ? "9999" : timestamp_t(time(nullptr)).str();
+	size_t checked(0);
+	uint64_t bytes(0);
+	std::map<std::string, size_t> counts;
+
+	auto verify = [&](photo_t& photo, const std::string& hash) -> std::string
+	{
+		struct stat sb;
+		if(::stat(photo.full_filename().c_str(), &sb) != 0)
+			return "missing";
+		if(static_cast<uint64_t>(sb.st_size) != photo.size || timestamp_t{sb.st_mtime}.str() != photo.mtime.str())
+			return "changed";
+
+		hasher_t::algorithm_t algorithm;
+		uint64_t chunk;
+		if(!parse_hash_name(hash, algorithm, chunk))
+			return "unsupported";
+
+		// Opening counts against the iops too.
+		throttle.take(0);
+
+		std::unique_ptr<fd_t> fd;
+		try
+		{
+			fd.reset(new fd_t(photo.full_filename().c_str(), O_RDONLY | O_CLOEXEC));
+		}
+		catch(const std::runtime_error& ex)
+		{
+			std::cerr << photo.full_filename() << ": " << ex.what() << "\n";
+			return "unreadable";
+		}
+
+		// Whatever is cached says nothing about the disk.
+		posix_fadvise(*fd, 0, 0, POSIX_FADV_DONTNEED);
+
+		uint64_t read(0);
+		if(!chunk)
+		{
+			auto hasher = hasher_t::create(algorithm);
+			if(!hash_range(*fd, 0, photo.size, *hasher, buffer, throttle, read))
+				return "unreadable";
+			bytes += read;
+			if(stop)
+				return {};
+			if(read != photo.size)
+				return "changed";
+			return hasher->final() == photo.checksum ? "ok" : "mismatch";
+		}
+
+		std::vector<chunk_t> chunks;
+		auto x = [&chunks](const std::tuple<int64_t, int64_t, std::string>& t)
+		{
+			chunks.push_back({static_cast<uint64_t>(std::get<0>(t)), static_cast<uint64_t>(std::get<1>(t)), std::get<2>(t)});
+		};
+		select_chunks.query<decltype(x), int64_t, int64_t, std::string>(x, hash, photo.checksum);
+
+		// Only the chunks that differ need looking at again.
+		auto root = hasher_t::create(algorithm);
+		std::vector<size_t> bad;
+		for(uint64_t offset = 0, i = 0; offset < photo.size || i == 0; offset += chunk, ++i)
+		{
+			auto hasher = hasher_t::create(algorithm);
+			if(!hash_range(*fd, offset, std::min(chunk, photo.size - offset), *hasher, buffer, throttle, read))
+				return "unreadable";
+			if(stop)
+				return {};
+
+			auto digest = hasher->final();
+			root->update(digest.data(), digest.size());
+			if(i < chunks.size() && chunks[i].digest != digest)
+				bad.push_back(i);
+			if(photo.size == 0)
+				break;
+		}
+		bytes += read;
+		if(read != photo.size)
+			return "changed";
+
+		for(auto i : bad)
+			std::cerr << photo.full_filename() << ": chunk " << i << " at " << chunks[i].offset << " (" << chunks[i].length << " bytes) differs\n";
+		return root->final() == photo.checksum && bad.empty() ? "ok" : "mismatch";
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	while(!stop)
+	{
+		std::vector<std::tuple<int64_t, std::string, std::string, int64_t, std::string, std::string, std::string> > rows;
+		auto x = [&rows](const std::tuple<int64_t, std::string, std::string, int64_t, std::string, std::string, std::string>& t)
+		{
+			rows.push_back(t);
+		};
+		select_oldest.query<decltype(x), int64_t, std::string, std::string, int64_t, std::string, std::string, std::string>(x, before, 1000);
+
+		bool done(rows.empty());
+		for(auto& row : rows)
+		{
+			if(stop || (options.limit && checked == options.limit))
+			{
+				done = true;
+				break;
+			}
+
+			photo_t photo{std::get<1>(row), std::get<2>(row)};
+			photo.id = std::get<0>(row);
+			photo.size = std::get<3>(row);
+			photo.mtime = timestamp_t{std::get<4>(row)};
+			photo.checksum = std::get<5>(row);
+
+			auto status = verify(photo, std::get<6>(row));
+			if(status.empty())
+				break;
+
+			if(status != "ok")
+				std::cout << photo.full_filename() << ": " << status << "\n";
+			update_verified.execute(timestamp_t(time(nullptr)).str(), status, photo.id);
+			++counts[status];
+			++checked;
+		}
+		if(done)
+			break;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "verified: " << checked;
+	for(auto& count : counts)
+		std::cout << "; " << count.first << ": " << count.second;
+	int64_t unhashed(0);
+	auto y = [&unhashed](const std::tuple<int64_t>& t)
+	{
+		unhashed = std::get<0>(t);
+	};
+	count_unhashed.query<decltype(y), int64_t>(y);
+	if(unhashed)
+		std::cout << "; not hashed: " << unhashed;
+	std::cout << "\n";
+	std::cout << "read: " << (bytes >> 20) << " MB in " << seconds << "s (" << bytes / 1048576.0 / std::max(seconds, 1e-9) << " MB/s)\n";
+	return true;
+}
@@ -0,0 +1,41 @@
+/*
+ * verify.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef VERIFY_H_
+#define VERIFY_H_
+#include <cstddef>
+#include <cstdint>
+#include "db.h"
+
+struct verify_options
+{
+	// bytes and reads per second; 0 for no limit.
+	uint64_t rate;
+	unsigned iops;
+
+	// files to check in this run; 0 for all of them.
+	std::size_t limit;
+
+	// idle io and cpu scheduling, so only otherwise unused time is taken.
+	bool idle;
+
+	// keep going round the least recently verified until interrupted.
+	bool continuous;
+
+	// bytes per read.
+	std::size_t buffer;
+
+	verify_options();
+};
+
+/*
+ * Re-hashes files, least recently verified first, and records in each row
+ * when it was checked and whether the content still matches its checksum.
+ * Reads bypass what is cached, so a scrub sees what is on the disk.
+ */
+bool verify_db(db_t& db, const verify_options& options);
+
+#endif /* VERIFY_H_ */
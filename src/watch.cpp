@@ -0,0 +1,315 @@
+/*
+ * watch.cpp
+ *
+ *  Created on: 19/10/2026
+ */
+
+#include "watch.h"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ingest.h"
+#include "photo.h"
+#include "scan.h"
+#include "thumbs.h"
+#include "timestamp.h"
+#include "util.h"
+
+namespace
+{
+
+volatile sig_atomic_t stop(false);
+
+void on_signal(int)
+{
+	stop = true;
+}
+
+const uint32_t dir_mask = IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+
+class inotify_t
+{
+private:
+	int fd;
+	std::map<int, std::string> paths;
+public:
+	inotify_t()
+	 : fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+	{
+		throw_if(fd == -1, strerror(errno));
+	}
+
+	inotify_t(const inotify_t&) = delete;
+	inotify_t& operator=(const inotify_t&) = delete;
+
+	// Watches path and every directory below it, listing the files found.
+	void add_tree(const std::string& path, std::vector<std::pair<std::string, std::string> >& files)
+	{
+		int wd = inotify_add_watch(fd, path.c_str(), dir_mask);
+		if(wd == -1)
+		{
+			std::cerr << "Unable to watch directory '" << path << "': " << strerror(errno) << "\n";
+			return;
+		}
+		paths[wd] = path;
+
+		auto delete_dir = [](DIR* d){ closedir(d); };
+		std::unique_ptr<DIR, decltype(delete_dir)> dir(opendir(path.c_str()), delete_dir);
+		if (!dir)
+			return;
+
+		while(dirent* entry = readdir(dir.get()))
+		{
+			std::string name = entry->d_name;
+			if(entry->d_type == DT_DIR)
+			{
+				if(name != "." && name != "..")
+					add_tree(path + '/' + name, files);
+			}
+			else if(entry->d_type == DT_REG)
+			{
+				files.emplace_back(path, name);
+			}
+		}
+	}
+
+	void remove_tree(const std::string& path)
+	{
+		for(auto it = begin(paths); it != end(paths); )
+		{
+			auto& p = it->second;
+			if(p == path || (p.size() > path.size() && p.compare(0, path.size(), path) == 0 && p[path.size()] == '/'))
+			{
+				inotify_rm_watch(fd, it->first);
+				it = paths.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	const std::string* path(int wd) const
+	{
+		auto it = paths.find(wd);
+		return it == paths.end() ? nullptr : &it->second;
+	}
+
+	void forget(int wd)
+	{
+		paths.erase(wd);
+	}
+
+	operator int() const
+	{
+		return fd;
+	}
+
+	~inotify_t()
+	{
+		close(fd);
+	}
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+}
+
+bool watch_db(db_t& db, const std::string& src, int debounce_ms, const scan_options& options)
+{
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, nullptr);
+	sigaction(SIGTERM, &sa, nullptr);
+
+	db_t::statement_t<std::string, std::string, uint64_t, std::string> remove_stale{db, "DELETE FROM photos WHERE file_name = ? AND path = ? AND NOT (size = ? AND mtime = ?)"};
+	db_t::statement_t<std::string, std::string> remove_photo{db, "DELETE FROM photos WHERE file_name = ? AND path = ?"};
+	db_t::statement_t<std::string, std::string, std::string> remove_tree{db, "DELETE FROM photos WHERE path = ? OR (path >= ? AND path < ?)"};
+
+	const auto debounce = std::chrono::milliseconds(debounce_ms);
+
+	// (path, file_name) -> time of the last event.
+	std::map<std::pair<std::string, std::string>, clock_type::time_point> pending;
+	// Directories deleted or moved away; their rows go once pending is empty.
+	std::set<std::string> removed_trees;
+
+	// Watches go in before the initial scan so nothing in between is missed.
+	read_options reading = options.read;
+	if(options.thumbnails)
+		reading.thumbnails = thumbnails_file(src);
+
+	inotify_t ino;
+	{
+		std::vector<std::pair<std::string, std::string> > files;
+		ino.add_tree(src, files);
+	}
+	if(!rebuild_db(db, src, options))
+		return false;
+
+	auto flush = [&](bool all)
+	{
+		auto now = clock_type::now();
+		size_t stat_new(0);
+		size_t stat_moved(0);
+		size_t stat_removed(0);
+
+		timestamp_t rebuilt(time(nullptr));
+		ingest_t ingest{db, rebuilt, reading};
+
+		std::vector<photo_t> gone;
+
+		db.execute("BEGIN");
+		for(auto it = begin(pending); it != end(pending); )
+		{
+			if(!all && now - it->second < debounce)
+			{
+				++it;
+				continue;
+			}
+
+			photo_t photo{it->first.second, it->first.first};
+			struct stat sb;
+			if(::stat(photo.full_filename().c_str(), &sb) == 0 && S_ISREG(sb.st_mode) && stat(photo))
+			{
+				remove_stale.execute(photo.file_name, photo.path, photo.size, photo.mtime.str());
+				switch(ingest.add(photo))
+				{
+					case ingest_t::added:
+						if(!photo.checksum.empty())
+							++stat_new;
+						break;
+					case ingest_t::moved:
+						++stat_moved;
+						break;
+					case ingest_t::old:
+						break;
+				}
+			}
+			else
+			{
+				gone.push_back(photo);
+			}
+			it = pending.erase(it);
+		}
+
+		// Removals last, so a rename has already carried the row across.
+		for(auto& photo : gone)
+		{
+			remove_photo.execute(photo.file_name, photo.path);
+			stat_removed += sqlite3_changes(db);
+		}
+		if(pending.empty())
+		{
+			for(auto& tree : removed_trees)
+			{
+				struct stat sb;
+				if(::stat(tree.c_str(), &sb) == 0)
+					continue;
+				remove_tree.execute(tree, tree + '/', tree + '0');
+				stat_removed += sqlite3_changes(db);
+			}
+			removed_trees.clear();
+		}
+		db.execute("COMMIT");
+
+		if(stat_new || stat_moved || stat_removed)
+			std::cout << "new: " << stat_new << "; moved: " << stat_moved << "; removed: " << stat_removed << "\n";
+	};
+
+	std::cerr << "Watching " << src << "\n";
+
+	alignas(inotify_event) char buf[64 * 1024];
+	while(!stop)
+	{
+		pollfd pfd{ino, POLLIN, 0};
+		int res = poll(&pfd, 1, pending.empty() && removed_trees.empty() ? -1 : debounce_ms);
+		if(res == -1)
+		{
+			if(errno == EINTR)
+				continue;
+			std::cerr << "poll: " << strerror(errno) << "\n";
+			return false;
+		}
+
+		bool overflow(false);
+		ssize_t len;
+		while((len = read(ino, buf, sizeof(buf))) > 0)
+		{
+			auto now = clock_type::now();
+			for(char* p = buf; p < buf + len; )
+			{
+				auto ev = reinterpret_cast<const inotify_event*>(p);
+				p += sizeof(inotify_event) + ev->len;
+
+				if(ev->mask & IN_Q_OVERFLOW)
+				{
+					overflow = true;
+					continue;
+				}
+				if(ev->mask & IN_IGNORED)
+				{
+					ino.forget(ev->wd);
+					continue;
+				}
+
+				auto dir = ino.path(ev->wd);
+				if(!dir || !ev->len)
+					continue;
+
+				std::string path = *dir;
+				std::string name = ev->name;
+				if(path == src && catalog_file(name))
+					continue;
+
+				if(ev->mask & IN_ISDIR)
+				{
+					std::string subdir = path + '/' + name;
+					if(ev->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						std::vector<std::pair<std::string, std::string> > files;
+						ino.add_tree(subdir, files);
+						for(auto& file : files)
+							pending[file] = now;
+					}
+					else if(ev->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						ino.remove_tree(subdir);
+						removed_trees.insert(subdir);
+					}
+				}
+				else if(ev->mask & (IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE))
+				{
+					pending[std::make_pair(path, name)] = now;
+				}
+			}
+		}
+
+		if(overflow)
+		{
+			std::cerr << "Event queue overflow; rescanning\n";
+			std::vector<std::pair<std::string, std::string> > files;
+			ino.add_tree(src, files);
+			flush(true);
+			if(!rebuild_db(db, src, options))
+				return false;
+		}
+
+		flush(false);
+	}
+
+	flush(true);
+	return true;
+}
@@ -0,0 +1,21 @@
+/*
+ * watch.h
+ *
+ *  Created on: 19/10/2026
+ */
+
+#ifndef WATCH_H_
+#define WATCH_H_
+#include <string>
+#include "db.h"
+#include "scan.h"
+
+/*
+ * Keeps the db up to date with changes under src using inotify.
+ * Changed files are indexed once they have been quiet for debounce_ms;
+ * runs until interrupted. Files are scanned and read with options, as a scan
+ * would, so the rows match those of the scan that built the db.
+ */
+bool watch_db(db_t& db, const std::string& src, int debounce_ms, const scan_options& options);
+
+#endif /* WATCH_H_ */